@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+// Compares the batched path kernels with the per point code the stroke outline used before.
+//
+// The previous code is reproduced here as it was: cubics evaluated point by point in double precision through QPointF,
+// and each segment extruded to its quad with scalar QVector2D math.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QVector>
+#include <QVector2D>
+#include <QtGlobal>
+
+#include "riveqtpathkernels.h"
+
+namespace {
+constexpr int curveCount = 1000;
+constexpr int segmentsPerCurve = 32;
+constexpr int iterations = 200;
+
+struct Curve
+{
+    QPointF p0, p1, p2, p3;
+};
+
+QPointF cubicBezier(const QPointF &startPoint, const QPointF &controlPoint1, const QPointF &controlPoint2, const QPointF &endPoint,
+                    qreal t)
+{
+    qreal oneMinusT = 1 - t;
+    qreal oneMinusTSquared = oneMinusT * oneMinusT;
+    qreal oneMinusTCubed = oneMinusTSquared * oneMinusT;
+    qreal tSquared = t * t;
+    qreal tCubed = tSquared * t;
+
+    QPointF point = oneMinusTCubed * startPoint + 3 * oneMinusTSquared * t * controlPoint1 + 3 * oneMinusT * tSquared * controlPoint2
+        + tCubed * endPoint;
+    return point;
+}
+
+QVector2D cubicBezierTangent(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3, const float t)
+{
+    const auto r = 3.f * (1.f - t) * (1.f - t) * (p1 - p0) + 6.f * (1.f - t) * t * (p2 - p1) + 3.f * t * t * (p3 - p2);
+    return QVector2D(r.x(), r.y()).normalized();
+}
+
+void evaluateCurvesScalar(const std::vector<Curve> &curves, QVector<QVector2D> &positions, QVector<QVector2D> &tangents)
+{
+    positions.resize(0);
+    tangents.resize(0);
+    for (const Curve &curve : curves) {
+        for (int j = 1; j <= segmentsPerCurve; ++j) {
+            const qreal t = static_cast<qreal>(j) / segmentsPerCurve;
+            const QPointF point = cubicBezier(curve.p0, curve.p1, curve.p2, curve.p3, t);
+            positions.append(QVector2D(point.x(), point.y()));
+            tangents.append(cubicBezierTangent(curve.p0, curve.p1, curve.p2, curve.p3, t));
+        }
+    }
+}
+
+void evaluateCurvesBatched(const std::vector<Curve> &curves, QVector<QVector2D> &positions, QVector<QVector2D> &tangents)
+{
+    positions.resize(int(curves.size()) * segmentsPerCurve);
+    tangents.resize(int(curves.size()) * segmentsPerCurve);
+    float *positionData = reinterpret_cast<float *>(positions.data());
+    float *tangentData = reinterpret_cast<float *>(tangents.data());
+    for (const Curve &curve : curves) {
+        RiveQtPathKernels::evaluateCubic(QVector2D(curve.p0), QVector2D(curve.p1), QVector2D(curve.p2), QVector2D(curve.p3),
+                                         segmentsPerCurve, positionData, tangentData);
+        positionData += 2 * segmentsPerCurve;
+        tangentData += 2 * segmentsPerCurve;
+    }
+}
+
+void extrudeScalar(const QVector<QVector2D> &starts, const QVector<QVector2D> &ends, const QVector<QVector2D> &normals,
+                   const QVector<QVector2D> &endNormals, float lineWidth, QVector<QVector2D> &vertices)
+{
+    vertices.resize(0);
+    for (int i = 0; i < starts.size(); ++i) {
+        const QVector2D &p1 = starts.at(i);
+        const QVector2D &p2 = ends.at(i);
+        const QVector2D offset = normals.at(i) * (lineWidth / 2.0);
+        const QVector2D offset2 = endNormals.at(i) * (lineWidth / 2.0);
+
+        vertices.append(p1 + offset);
+        vertices.append(p1 - offset);
+        vertices.append(p2 + offset2);
+
+        vertices.append(p2 + offset2);
+        vertices.append(p2 - offset2);
+        vertices.append(p1 - offset);
+    }
+}
+
+void extrudeBatched(const QVector<QVector2D> &starts, const QVector<QVector2D> &ends, const QVector<QVector2D> &normals,
+                    const QVector<QVector2D> &endNormals, float lineWidth, QVector<QVector2D> &vertices)
+{
+    vertices.resize(6 * starts.size());
+    RiveQtPathKernels::extrudeSegments(reinterpret_cast<const float *>(starts.constData()), reinterpret_cast<const float *>(ends.constData()),
+                                       reinterpret_cast<const float *>(normals.constData()),
+                                       reinterpret_cast<const float *>(endNormals.constData()), starts.size(), lineWidth / 2.0,
+                                       reinterpret_cast<float *>(vertices.data()));
+}
+
+float maximumDifference(const QVector<QVector2D> &a, const QVector<QVector2D> &b)
+{
+    if (a.size() != b.size()) {
+        return INFINITY;
+    }
+
+    float difference = 0.f;
+    for (int i = 0; i < a.size(); ++i) {
+        difference = std::max(difference, (a.at(i) - b.at(i)).length());
+    }
+    return difference;
+}
+
+// best of all iterations in microseconds, the least disturbed run tells the most about the code itself
+template<typename Function>
+double measure(Function function)
+{
+    qint64 best = -1;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best / 1000.0;
+}
+}
+
+int main()
+{
+    // deterministic curves, spread over a typical artboard
+    std::vector<Curve> curves;
+    curves.reserve(curveCount);
+    for (int i = 0; i < curveCount; ++i) {
+        const qreal x = (i * 37) % 500;
+        const qreal y = (i * 91) % 500;
+        curves.push_back({ QPointF(x, y), QPointF(x + 40, y - 25), QPointF(x + 80, y + 60), QPointF(x + 120, y + 10) });
+    }
+
+    QVector<QVector2D> scalarPositions, scalarTangents, batchedPositions, batchedTangents;
+    const double scalarCurves = measure([&]() { evaluateCurvesScalar(curves, scalarPositions, scalarTangents); });
+    const double batchedCurves = measure([&]() { evaluateCurvesBatched(curves, batchedPositions, batchedTangents); });
+
+    // segments between consecutive points with the normals of their tangents, as the stroke outline builds them
+    QVector<QVector2D> starts, ends, normals, endNormals;
+    for (int i = 0; i + 1 < batchedPositions.size(); ++i) {
+        starts.append(batchedPositions.at(i));
+        ends.append(batchedPositions.at(i + 1));
+        normals.append(QVector2D(-batchedTangents.at(i).y(), batchedTangents.at(i).x()));
+        endNormals.append(QVector2D(-batchedTangents.at(i + 1).y(), batchedTangents.at(i + 1).x()));
+    }
+
+    QVector<QVector2D> scalarQuads, batchedQuads;
+    const double scalarExtrude = measure([&]() { extrudeScalar(starts, ends, normals, endNormals, 3.f, scalarQuads); });
+    const double batchedExtrude = measure([&]() { extrudeBatched(starts, ends, normals, endNormals, 3.f, batchedQuads); });
+
+    // numbers are only comparable together with the setup they were taken on
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    const char *kernelPath = "SSE2";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    const char *kernelPath = "NEON";
+#else
+    const char *kernelPath = "scalar";
+#endif
+    std::printf("Qt %s, %s kernels\n", qVersion(), kernelPath);
+    std::printf("%d cubics with %d segments each, best of %d runs\n", curveCount, segmentsPerCurve, iterations);
+    std::printf("evaluate cubics:  previous %9.1f us  kernels %9.1f us  speedup %.2fx  max difference %g\n", scalarCurves, batchedCurves,
+                scalarCurves / batchedCurves, std::max(maximumDifference(scalarPositions, batchedPositions),
+                                                       maximumDifference(scalarTangents, batchedTangents)));
+    std::printf("extrude segments: previous %9.1f us  kernels %9.1f us  speedup %.2fx  max difference %g\n", scalarExtrude, batchedExtrude,
+                scalarExtrude / batchedExtrude, maximumDifference(scalarQuads, batchedQuads));
+
+    return 0;
+}
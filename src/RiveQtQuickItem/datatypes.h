@@ -57,6 +57,9 @@ struct RiveRenderSettings
     Q_PROPERTY(RenderQuality renderQuality MEMBER renderQuality)
     Q_PROPERTY(QSGRendererInterface::GraphicsApi graphicsApi MEMBER graphicsApi)
     Q_PROPERTY(FillMode fillMode MEMBER fillMode)
+    Q_PROPERTY(FillMethod fillMethod MEMBER fillMethod)
+    Q_PROPERTY(AdvanceMode advanceMode MEMBER advanceMode)
+    Q_PROPERTY(qreal renderScale MEMBER renderScale)
 
 public:
     enum RenderQuality
@@ -75,8 +78,30 @@ public:
     };
     Q_ENUM(FillMode)
 
+    // how fills of paths are turned into triangles
+    enum FillMethod
+    {
+        Tessellator,
+        QtTriangulator,
+        StencilAndCover // only supported by the rhi renderer, the others fall back to Tessellator
+    };
+    Q_ENUM(FillMethod)
+
+    // where the artboard gets advanced and recorded for rendering
+    enum AdvanceMode
+    {
+        AdvanceDuringSync, // in the scene graph sync, gui and render thread are both blocked meanwhile
+        AdvanceOnGuiThread // after the animations of the window, the sync only hands the recorded frame over
+    };
+    Q_ENUM(AdvanceMode)
+
     RenderQuality renderQuality { Medium };
     QSGRendererInterface::GraphicsApi graphicsApi { QSGRendererInterface::GraphicsApi::Software };
     FillMode fillMode { PreserveAspectFit };
+    FillMethod fillMethod { Tessellator };
+    AdvanceMode advanceMode { AdvanceDuringSync };
+    // pixels rendered per logical pixel of the item, 0 follows the device pixel ratio of the window
+    // below that trades sharpness for frame time, above it is supersampled
+    qreal renderScale { 0.0 };
 };
 Q_DECLARE_METATYPE(RiveRenderSettings)
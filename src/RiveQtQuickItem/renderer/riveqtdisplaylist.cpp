@@ -0,0 +1,426 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <type_traits>
+
+#include <QBrush>
+#include <QTransform>
+
+#include "rqqplogging.h"
+#include "riveqtpath.h"
+#include "renderer/riveqtdisplaylist.h"
+#include "renderer/riveqtimage.h"
+#include "renderer/riveqtpainterrenderer.h"
+#include "renderer/riveqtutils.h"
+
+namespace {
+// FNV-1a, the content hash only needs to tell frames apart
+constexpr quint64 hashSeed = 14695981039346656037ULL;
+
+quint64 hashBytes(quint64 hash, const void *data, size_t size)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template<typename T>
+quint64 hashValue(quint64 hash, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values can be hashed byte wise");
+    return hashBytes(hash, &value, sizeof(value));
+}
+
+// the pixels of an image show up once its decode finished, so that has to change the hash as well
+quint64 hashImage(quint64 hash, const rive::RenderImage *image)
+{
+    hash = hashValue(hash, image);
+    return hashValue(hash, static_cast<const RiveQtImage *>(image)->generation());
+}
+
+quint64 hashPainterPath(quint64 hash, const QPainterPath &path)
+{
+    hash = hashValue(hash, int(path.fillRule()));
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element &element = path.elementAt(i);
+        hash = hashValue(hash, int(element.type));
+        hash = hashValue(hash, element.x);
+        hash = hashValue(hash, element.y);
+    }
+    return hash;
+}
+
+quint64 hashBrush(quint64 hash, const QBrush &brush)
+{
+    hash = hashValue(hash, int(brush.style()));
+    hash = hashValue(hash, brush.color().rgba());
+
+    const QGradient *gradient = brush.gradient();
+    if (!gradient) {
+        return hash;
+    }
+
+    hash = hashValue(hash, int(gradient->type()));
+    for (const QGradientStop &stop : gradient->stops()) {
+        hash = hashValue(hash, stop.first);
+        hash = hashValue(hash, stop.second.rgba());
+    }
+
+    switch (gradient->type()) {
+    case QGradient::LinearGradient: {
+        const auto *linear = static_cast<const QLinearGradient *>(gradient);
+        hash = hashValue(hash, linear->start().x());
+        hash = hashValue(hash, linear->start().y());
+        hash = hashValue(hash, linear->finalStop().x());
+        hash = hashValue(hash, linear->finalStop().y());
+        break;
+    }
+    case QGradient::RadialGradient: {
+        const auto *radial = static_cast<const QRadialGradient *>(gradient);
+        hash = hashValue(hash, radial->center().x());
+        hash = hashValue(hash, radial->center().y());
+        hash = hashValue(hash, radial->radius());
+        break;
+    }
+    default:
+        break;
+    }
+    return hash;
+}
+
+QRectF mapRect(const rive::Mat2D &matrix, const QRectF &rect)
+{
+    return QTransform(matrix[0], matrix[1], matrix[2], matrix[3], matrix[4], matrix[5]).mapRect(rect);
+}
+
+// mirrors the paths RiveQtFactory creates for the render type
+bool usesRiveQtPaths(RiveQtFactory::RiveQtRenderType renderType)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return renderType == RiveQtFactory::RiveQtRenderType::RHIRenderer;
+#else
+    return renderType == RiveQtFactory::RiveQtRenderType::QOpenGLRenderer;
+#endif
+}
+}
+
+RiveQtDisplayList::RiveQtDisplayList(RiveQtFactory::RiveQtRenderType renderType)
+    : rive::Renderer()
+    , m_renderType(renderType)
+{
+}
+
+RiveQtDisplayList::~RiveQtDisplayList() = default;
+
+void RiveQtDisplayList::beginRecording()
+{
+    m_commands.clear();
+    m_paths.clear();
+    m_images.clear();
+    m_meshes.clear();
+    m_draws.clear();
+    m_paintCount = 0;
+    m_painterPathCount = 0;
+
+    m_transform = rive::Mat2D();
+    m_transformStack.clear();
+    m_clip = Clip();
+    m_clipStack.clear();
+    m_frame++;
+    m_contentHash = hashSeed;
+    m_commandHash = hashSeed;
+}
+
+void RiveQtDisplayList::endRecording()
+{
+    if (!m_transformStack.empty()) {
+        qCDebug(rqqpRendering) << "Display list recorded" << m_transformStack.size() << "save without restore";
+    }
+
+    for (auto it = m_pathSnapshots.begin(); it != m_pathSnapshots.end();) {
+        if (it->second.lastFrame != m_frame) {
+            it = m_pathSnapshots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RiveQtDisplayList::replay(rive::Renderer *renderer) const
+{
+    if (!renderer) {
+        return;
+    }
+
+    for (const Command &command : m_commands) {
+        switch (command.type) {
+        case Command::Save:
+            renderer->save();
+            break;
+        case Command::Restore:
+            renderer->restore();
+            break;
+        case Command::Transform:
+            renderer->transform(command.transform);
+            break;
+        case Command::ClipPath:
+            renderer->clipPath(m_paths[command.index]);
+            break;
+        case Command::DrawPath:
+            renderer->drawPath(m_paths[command.index], m_paints[command.paintIndex].get());
+            break;
+        case Command::DrawImage:
+            renderer->drawImage(m_images[command.index], command.blendMode, command.opacity);
+            break;
+        case Command::DrawImageMesh: {
+            const Mesh &mesh = m_meshes[command.index];
+            renderer->drawImageMesh(mesh.image, mesh.vertices, mesh.uvCoords, mesh.indices, command.blendMode, command.opacity);
+            break;
+        }
+        }
+    }
+}
+
+void RiveQtDisplayList::save()
+{
+    m_transformStack.push_back(m_transform);
+    m_clipStack.push_back(m_clip);
+    append(Command::Save);
+}
+
+void RiveQtDisplayList::restore()
+{
+    if (m_transformStack.empty()) {
+        qCDebug(rqqpRendering) << "Display list restore without save";
+        append(Command::Restore);
+        return;
+    }
+
+    m_transform = m_transformStack.back();
+    m_transformStack.pop_back();
+    m_clip = m_clipStack.back();
+    m_clipStack.pop_back();
+
+    // transforms right before a restore do not affect anything, a save restore pair without anything in between neither
+    while (!m_commands.empty() && m_commands.back().type == Command::Transform) {
+        m_commands.pop_back();
+    }
+    if (!m_commands.empty() && m_commands.back().type == Command::Save) {
+        m_commands.pop_back();
+        return;
+    }
+
+    append(Command::Restore);
+}
+
+void RiveQtDisplayList::transform(const rive::Mat2D &transform)
+{
+    m_transform = m_transform * transform;
+
+    // consecutive transforms are combined into one
+    if (!m_commands.empty() && m_commands.back().type == Command::Transform) {
+        m_commands.back().transform = m_commands.back().transform * transform;
+        return;
+    }
+
+    append(Command::Transform);
+    m_commands.back().transform = transform;
+}
+
+void RiveQtDisplayList::drawPath(rive::RenderPath *path, rive::RenderPaint *paint)
+{
+    if (!path || !paint) {
+        return;
+    }
+
+    const RiveQtPaint *qtPaint = static_cast<const RiveQtPaint *>(paint);
+    const int pathIndex = snapshotPath(path);
+    const int paintIndex = snapshotPaint(paint);
+    const quint64 hash = append(Command::DrawPath, pathIndex, paintIndex, qtPaint->blendMode(), qtPaint->opacity());
+
+    QRectF bounds = pathBounds(pathIndex);
+    const RiveQtPaint *snapshot = m_paints[paintIndex].get();
+    if (snapshot->paintStyle() == rive::RenderPaintStyle::stroke) {
+        // miter joins reach out up to the miter limit, square caps by sqrt(2)
+        const qreal extent = snapshot->pen().widthF() * 0.5 * qMax<qreal>(snapshot->pen().miterLimit(), 1.5);
+        bounds.adjust(-extent, -extent, extent, extent);
+    }
+    appendDraw(bounds, hash);
+}
+
+void RiveQtDisplayList::clipPath(rive::RenderPath *path)
+{
+    if (!path) {
+        return;
+    }
+
+    const int pathIndex = snapshotPath(path);
+    const quint64 hash = append(Command::ClipPath, pathIndex);
+
+    // Backends either replace the clip or intersect it with the one before, the latest clip contains the result of both.
+    // An empty path does not clip.
+    const QRectF bounds = pathBounds(pathIndex);
+    m_clip.active = !bounds.isNull();
+    m_clip.bounds = mapRect(m_transform, bounds);
+    m_clip.hash = hashValue(m_clip.hash, hash);
+}
+
+void RiveQtDisplayList::waitForDecode(const rive::RenderImage *image)
+{
+    // the frame skips an image still decoding, whoever recorded it has to record another one once it is done
+    if (m_decodeListener) {
+        static_cast<const RiveQtImage *>(image)->waitForDecode(m_decodeListener);
+    }
+}
+
+void RiveQtDisplayList::drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity)
+{
+    if (!image) {
+        return;
+    }
+
+    waitForDecode(image);
+    m_images.push_back(image);
+    m_commandHash = hashImage(m_commandHash, image);
+    const quint64 hash = append(Command::DrawImage, int(m_images.size()) - 1, -1, blendMode, opacity);
+    appendDraw(QRectF(0, 0, image->width(), image->height()), hash);
+}
+
+void RiveQtDisplayList::drawImageMesh(const rive::RenderImage *image, rive::rcp<rive::RenderBuffer> vertices_f32,
+                                      rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16,
+                                      rive::BlendMode blendMode, float opacity)
+{
+    if (!image) {
+        return;
+    }
+
+    waitForDecode(image);
+    m_meshes.push_back({ image, vertices_f32, uvCoords_f32, indices_u16 });
+
+    // deformed meshes might update their vertices in place
+    m_commandHash = hashImage(m_commandHash, image);
+    m_commandHash = hashValue(m_commandHash, uvCoords_f32.get());
+    m_commandHash = hashValue(m_commandHash, indices_u16.get());
+    QRectF bounds;
+    if (vertices_f32) {
+        const auto *vertices = static_cast<const RiveQtBufferF32 *>(vertices_f32.get());
+        m_commandHash = hashBytes(m_commandHash, vertices->data(), vertices->size());
+
+        if (vertices->count() >= 2) {
+            const float *data = vertices->data();
+            float minX = data[0], maxX = data[0], minY = data[1], maxY = data[1];
+            for (uint i = 2; i + 1 < vertices->count(); i += 2) {
+                minX = qMin(minX, data[i]);
+                maxX = qMax(maxX, data[i]);
+                minY = qMin(minY, data[i + 1]);
+                maxY = qMax(maxY, data[i + 1]);
+            }
+            bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+        }
+    }
+
+    const quint64 hash = append(Command::DrawImageMesh, int(m_meshes.size()) - 1, -1, blendMode, opacity);
+    appendDraw(bounds, hash);
+}
+
+int RiveQtDisplayList::snapshotPath(rive::RenderPath *path)
+{
+    if (!usesRiveQtPaths(m_renderType)) {
+        // painter paths are implicitly shared, copying them every frame is cheap
+        if (m_painterPathCount == int(m_painterPaths.size())) {
+            m_painterPaths.push_back(std::make_unique<RiveQtPainterPath>());
+        }
+        RiveQtPainterPath *snapshot = m_painterPaths[m_painterPathCount++].get();
+        snapshot->setQPainterPath(static_cast<RiveQtPainterPath *>(path)->toQPainterPath());
+        m_commandHash = hashPainterPath(m_commandHash, snapshot->toQPainterPath());
+        m_paths.push_back(snapshot);
+        return int(m_paths.size()) - 1;
+    }
+
+    RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
+    PathSnapshot &snapshot = m_pathSnapshots[qtPath->id()];
+
+    if (!snapshot.path) {
+        snapshot.path = std::make_unique<RiveQtPath>(*qtPath);
+        snapshot.sourceGeneration = qtPath->generation();
+    } else if (snapshot.sourceGeneration != qtPath->generation()) {
+        snapshot.path->setQPainterPath(qtPath->toQPainterPath());
+        snapshot.sourceGeneration = qtPath->generation();
+    }
+    snapshot.lastFrame = m_frame;
+
+    // the generation of the snapshot itself also changes with the settings of the backend
+    m_commandHash = hashValue(m_commandHash, qtPath->id());
+    m_commandHash = hashValue(m_commandHash, snapshot.sourceGeneration);
+
+    m_paths.push_back(snapshot.path.get());
+    return int(m_paths.size()) - 1;
+}
+
+int RiveQtDisplayList::snapshotPaint(rive::RenderPaint *paint)
+{
+    if (m_paintCount == int(m_paints.size())) {
+        m_paints.push_back(std::make_unique<RiveQtPaint>());
+    }
+
+    RiveQtPaint *snapshot = m_paints[m_paintCount].get();
+    snapshot->copyState(*static_cast<RiveQtPaint *>(paint));
+
+    m_commandHash = hashValue(m_commandHash, int(snapshot->paintStyle()));
+    m_commandHash = hashValue(m_commandHash, snapshot->color().rgba());
+    m_commandHash = hashBrush(m_commandHash, snapshot->brush());
+    m_commandHash = hashValue(m_commandHash, snapshot->pen().widthF());
+    m_commandHash = hashValue(m_commandHash, int(snapshot->pen().joinStyle()));
+    m_commandHash = hashValue(m_commandHash, int(snapshot->pen().capStyle()));
+    // trim paths and other stroke effects change the stroke without touching the path
+    m_commandHash = hashValue(m_commandHash, snapshot->strokeGeneration());
+
+    return m_paintCount++;
+}
+
+quint64 RiveQtDisplayList::append(Command::Type type, int index, int paintIndex, rive::BlendMode blendMode, float opacity)
+{
+    Command command;
+    command.type = type;
+    command.blendMode = blendMode;
+    command.opacity = opacity;
+    command.index = index;
+    command.paintIndex = paintIndex;
+    command.transform = m_transform;
+    m_commands.push_back(command);
+
+    m_commandHash = hashValue(m_commandHash, type);
+    m_commandHash = hashValue(m_commandHash, blendMode);
+    m_commandHash = hashValue(m_commandHash, opacity);
+    for (int i = 0; i < 6; ++i) {
+        m_commandHash = hashValue(m_commandHash, m_transform[i]);
+    }
+
+    const quint64 hash = m_commandHash;
+    m_contentHash = hashValue(m_contentHash, hash);
+    m_commandHash = hashSeed;
+    return hash;
+}
+
+void RiveQtDisplayList::appendDraw(const QRectF &bounds, quint64 hash)
+{
+    QRectF drawBounds = mapRect(m_transform, bounds);
+    if (m_clip.active) {
+        drawBounds &= m_clip.bounds;
+    }
+    m_draws.push_back({ drawBounds, hashValue(hash, m_clip.hash) });
+}
+
+QRectF RiveQtDisplayList::pathBounds(int index) const
+{
+    // the control points contain the curves, cheaper than the exact bounds and good enough here
+    if (usesRiveQtPaths(m_renderType)) {
+        return static_cast<const RiveQtPath *>(m_paths[index])->toQPainterPath().controlPointRect();
+    }
+    return static_cast<const RiveQtPainterPath *>(m_paths[index])->toQPainterPath().controlPointRect();
+}
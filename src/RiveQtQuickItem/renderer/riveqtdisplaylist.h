@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QRectF>
+#include <QtGlobal>
+
+#include <rive/renderer.hpp>
+#include <rive/math/mat2d.hpp>
+#include <rive/shapes/paint/blend_mode.hpp>
+
+#include "riveqtfactory.h"
+
+class RiveQtDecodeListener;
+class RiveQtPaint;
+class RiveQtPainterPath;
+class RiveQtPath;
+
+// Records the draw calls of an artboard into a compact command stream, to be replayed by any backend later on.
+//
+// Paths and paints are frozen when they get recorded, so the artboard can advance while a frame recorded
+// before is still replayed. Snapshots of RiveQtPaths are kept over frames and only updated when their
+// source changed, they keep their id and the geometry caches of the backends keep working.
+class RiveQtDisplayList : public rive::Renderer
+{
+public:
+    struct Command
+    {
+        enum Type : quint8
+        {
+            Save,
+            Restore,
+            Transform,
+            ClipPath,
+            DrawPath,
+            DrawImage,
+            DrawImageMesh,
+        };
+
+        Type type;
+        rive::BlendMode blendMode;
+        float opacity;
+        int index; // path, image or mesh, depending on the type
+        int paintIndex; // DrawPath only
+        // Transform: the matrix to apply, all others: the resolved matrix the command is drawn with
+        rive::Mat2D transform;
+    };
+
+    // A path, image or mesh drawn in the recorded frame
+    struct Draw
+    {
+        QRectF bounds; // in artboard coordinates, conservative and limited to the clip of the draw
+        quint64 hash; // everything deciding about the pixels of the draw, its clip included
+    };
+
+    // renderType decides about the type of the path snapshots, they need to match the backend
+    explicit RiveQtDisplayList(RiveQtFactory::RiveQtRenderType renderType);
+    ~RiveQtDisplayList();
+
+    // drops the commands of the last frame, everything drawn from now on gets recorded
+    void beginRecording();
+    // releases the snapshots of paths that were not drawn in the recorded frame
+    void endRecording();
+
+    void replay(rive::Renderer *renderer) const;
+
+    // notified once an image decodes that had no pixels when it got recorded, the frame skipped it
+    void setDecodeListener(const std::shared_ptr<RiveQtDecodeListener> &decodeListener) { m_decodeListener = decodeListener; }
+
+    const std::vector<Command> &commands() const { return m_commands; }
+    bool isEmpty() const { return m_commands.empty(); }
+    // in drawing order, comparing them with the draws of an older frame tells which areas changed
+    const std::vector<Draw> &draws() const { return m_draws; }
+    // Hash over everything the recorded frame shows: commands, matrices, paints and the geometry generations of the paths.
+    // Two frames with the same hash look the same, a backend can keep the result of the last one.
+    quint64 contentHash() const { return m_contentHash; }
+
+    void save() override;
+    void restore() override;
+    void transform(const rive::Mat2D &transform) override;
+    void drawPath(rive::RenderPath *path, rive::RenderPaint *paint) override;
+    void clipPath(rive::RenderPath *path) override;
+    void drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity) override;
+    void drawImageMesh(const rive::RenderImage *image, rive::rcp<rive::RenderBuffer> vertices_f32,
+                       rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16, rive::BlendMode blendMode,
+                       float opacity) override;
+
+private:
+    struct PathSnapshot
+    {
+        std::unique_ptr<RiveQtPath> path;
+        quint64 sourceGeneration { 0 };
+        quint64 lastFrame { 0 };
+    };
+
+    struct Clip
+    {
+        bool active { false };
+        QRectF bounds;
+        quint64 hash { 0 };
+    };
+
+    struct Mesh
+    {
+        const rive::RenderImage *image { nullptr };
+        rive::rcp<rive::RenderBuffer> vertices;
+        rive::rcp<rive::RenderBuffer> uvCoords;
+        rive::rcp<rive::RenderBuffer> indices;
+    };
+
+    int snapshotPath(rive::RenderPath *path);
+    int snapshotPaint(rive::RenderPaint *paint);
+    // returns the hash of the appended command
+    quint64 append(Command::Type type, int index = -1, int paintIndex = -1, rive::BlendMode blendMode = rive::BlendMode::srcOver,
+                   float opacity = 1.f);
+    // bounds are in the coordinates of the current transform
+    void appendDraw(const QRectF &bounds, quint64 hash);
+    QRectF pathBounds(int index) const;
+    void waitForDecode(const rive::RenderImage *image);
+
+    RiveQtFactory::RiveQtRenderType m_renderType;
+
+    std::vector<Command> m_commands;
+    std::vector<rive::RenderPath *> m_paths; // snapshots referenced by the commands
+    std::vector<const rive::RenderImage *> m_images;
+    std::vector<Mesh> m_meshes;
+    std::vector<Draw> m_draws;
+
+    // pools, grown to the largest frame and reused after that
+    std::vector<std::unique_ptr<RiveQtPaint>> m_paints;
+    int m_paintCount { 0 };
+    std::vector<std::unique_ptr<RiveQtPainterPath>> m_painterPaths;
+    int m_painterPathCount { 0 };
+
+    std::unordered_map<quint64, PathSnapshot> m_pathSnapshots; // by the id of their source path
+    quint64 m_frame { 0 };
+    quint64 m_contentHash { 0 };
+    quint64 m_commandHash { 0 }; // of the command getting recorded
+    std::shared_ptr<RiveQtDecodeListener> m_decodeListener;
+
+    rive::Mat2D m_transform;
+    std::vector<rive::Mat2D> m_transformStack;
+    Clip m_clip;
+    std::vector<Clip> m_clipStack;
+};
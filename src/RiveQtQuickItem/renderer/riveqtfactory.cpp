@@ -6,6 +6,7 @@
 #include <QQuickWindow>
 
 #include "renderer/riveqtfactory.h"
+#include "renderer/riveqtdisplaylist.h"
 #include "renderer/riveqtfont.h"
 #include "renderer/riveqtpainterrenderer.h"
 #include "riveqsgrhirendernode.h"
@@ -42,6 +43,11 @@ RiveQSGRenderNode *RiveQtFactory::renderNode(QQuickWindow *window, std::weak_ptr
     }
 }
 
+std::unique_ptr<RiveQtDisplayList> RiveQtFactory::makeDisplayList()
+{
+    return std::make_unique<RiveQtDisplayList>(renderType());
+}
+
 rive::rcp<rive::RenderBuffer> RiveQtFactory::makeBufferU16(rive::Span<const uint16_t> data)
 {
     auto buffer = new RiveQtBufferU16(data.size());
@@ -90,7 +96,11 @@ std::unique_ptr<rive::RenderPath> RiveQtFactory::makeRenderPath(rive::RawPath &r
 #else
     case RiveQtRenderType::QOpenGLRenderer:
 #endif
-        return std::make_unique<RiveQtPath>(rawPath, fillRule, segmentCount());
+    {
+        auto path = std::make_unique<RiveQtPath>(rawPath, fillRule, segmentCount());
+        path->setPixelTolerance(pixelTolerance());
+        return path;
+    }
     case RiveQtRenderType::None:
     default:
         return std::make_unique<RiveQtPainterPath>(rawPath, fillRule); // TODO Add Empty Path
@@ -107,7 +117,11 @@ std::unique_ptr<rive::RenderPath> RiveQtFactory::makeEmptyRenderPath()
 #else
     case RiveQtRenderType::QOpenGLRenderer:
 #endif
-        return std::make_unique<RiveQtPath>(segmentCount());
+    {
+        auto path = std::make_unique<RiveQtPath>(segmentCount());
+        path->setPixelTolerance(pixelTolerance());
+        return path;
+    }
     case RiveQtRenderType::None:
     default:
         return std::make_unique<RiveQtPainterPath>(); // TODO Add Empty Path
@@ -121,13 +135,14 @@ std::unique_ptr<rive::RenderPaint> RiveQtFactory::makeRenderPaint()
 
 std::unique_ptr<rive::RenderImage> RiveQtFactory::decodeImage(rive::Span<const uint8_t> span)
 {
+    // only the header is read here, pixels get decoded once the image is drawn for the first time
     QByteArray imageData(reinterpret_cast<const char *>(span.data()), static_cast<int>(span.size()));
-    QImage image = QImage::fromData(imageData);
+    auto image = std::make_unique<RiveQtImage>(imageData);
 
-    if (image.isNull()) {
+    if (!image->isValid()) {
         return nullptr;
     }
-    return std::make_unique<RiveQtImage>(image);
+    return image;
 }
 
 rive::rcp<rive::Font> RiveQtFactory::decodeFont(rive::Span<const uint8_t> span)
@@ -163,6 +178,22 @@ unsigned int RiveQtFactory::segmentCount()
     }
 }
 
+float RiveQtFactory::pixelTolerance()
+{
+    // maximum distance of flattened curves to the real curves, in pixels
+    switch (m_renderSettings.renderQuality) {
+    case RiveRenderSettings::Low:
+        return 1.0f;
+
+    default:
+    case RiveRenderSettings::Medium:
+        return 0.5f;
+
+    case RiveRenderSettings::High:
+        return 0.25f;
+    }
+}
+
 RiveQtFactory::RiveQtRenderType RiveQtFactory::renderType()
 {
     switch (m_renderSettings.graphicsApi) {
@@ -18,6 +18,7 @@
 #include "riveqsgrendernode.h"
 
 class RiveQtQuickItem;
+class RiveQtDisplayList;
 
 class RiveQtFactory : public rive::Factory
 {
@@ -39,6 +40,8 @@ public:
     void setRenderSettings(const RiveRenderSettings &renderSettings) { m_renderSettings = renderSettings; }
 
     RiveQSGRenderNode *renderNode(QQuickWindow *window, std::weak_ptr<rive::ArtboardInstance> artboardInstance, const QRectF &geometry);
+    // display list with snapshots of the paths this factory creates, to record artboards outside of the render nodes
+    std::unique_ptr<RiveQtDisplayList> makeDisplayList();
 
     rive::rcp<rive::RenderBuffer> makeBufferU16(rive::Span<const uint16_t> data) override;
     rive::rcp<rive::RenderBuffer> makeBufferU32(rive::Span<const uint32_t> data) override;
@@ -53,6 +56,7 @@ public:
 
 private:
     unsigned segmentCount();
+    float pixelTolerance();
 
     RiveQtRenderType renderType();
 
@@ -0,0 +1,322 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <atomic>
+#include <algorithm>
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+#include "renderer/riveqtimage.h"
+#include "rqqplogging.h"
+
+struct RiveQtImage::SharedState
+{
+    ~SharedState();
+
+    QMutex mutex;
+    QByteArray encodedData;
+    QImage image;
+    bool decoding { false };
+    bool decodeFailed { false };
+    bool evictable { true };
+    quint64 lastUsed { 0 };
+    qint64 lastUsedTime { 0 }; // milliseconds, see usageTime
+    std::atomic<quint64> generation { 0 };
+    // frames that skipped the image, notified once it is decoded
+    QVector<std::weak_ptr<RiveQtDecodeListener>> decodeListeners;
+};
+
+namespace {
+std::atomic<quint64> nextImageId { 1 };
+std::atomic<quint64> useCounter { 0 };
+
+std::atomic<qint64> encodedBytes { 0 };
+std::atomic<qint64> decodedBytes { 0 };
+std::atomic<qint64> residentBytes { 0 };
+std::atomic<int> pendingDecodeCount { 0 };
+std::atomic<qint64> residentBudget { 0 };
+
+// Images drawn within this time are still on screen, evicting them would only decode them again for the next frame.
+// Images are shared by items of all windows, there is no frame counter common to them, so this is a time and not a frame count.
+constexpr qint64 inUseMilliseconds = 500;
+
+qint64 usageTime()
+{
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer.elapsed();
+}
+
+void markUsed(RiveQtImage::SharedState *state)
+{
+    state->lastUsed = ++useCounter;
+    state->lastUsedTime = usageTime();
+}
+
+// all images that may be evicted, used to find the least recently used ones
+QMutex registryMutex;
+QVector<std::weak_ptr<RiveQtImage::SharedState>> registry;
+
+void registerState(const std::shared_ptr<RiveQtImage::SharedState> &state)
+{
+    QMutexLocker locker(&registryMutex);
+    registry.erase(std::remove_if(registry.begin(), registry.end(), [](const auto &entry) { return entry.expired(); }), registry.end());
+    registry.append(state);
+}
+
+void decode(const std::shared_ptr<RiveQtImage::SharedState> &state)
+{
+    QByteArray encodedData;
+    {
+        QMutexLocker locker(&state->mutex);
+        encodedData = state->encodedData;
+    }
+
+    QImage image = QImage::fromData(encodedData);
+    if (image.isNull()) {
+        // the data will not get any better, the image stays empty instead of being decoded again every frame
+        qCWarning(rqqpRendering) << "Decoding image failed.";
+        QMutexLocker locker(&state->mutex);
+        state->decoding = false;
+        state->decodeFailed = true;
+        pendingDecodeCount--;
+        return;
+    }
+
+    QVector<std::weak_ptr<RiveQtDecodeListener>> decodeListeners;
+    {
+        QMutexLocker locker(&state->mutex);
+        state->image = image;
+        state->decoding = false;
+        markUsed(state.get());
+        decodedBytes += image.sizeInBytes();
+        residentBytes += image.sizeInBytes();
+        pendingDecodeCount--;
+        std::swap(decodeListeners, state->decodeListeners);
+    }
+    state->generation++;
+
+    for (const auto &entry : qAsConst(decodeListeners)) {
+        if (auto listener = entry.lock()) {
+            listener->notify();
+        }
+    }
+
+    const qint64 budget = residentBudget;
+    if (budget > 0 && residentBytes > budget) {
+        RiveQtImage::trimResidentBytes(budget);
+    }
+}
+}
+
+RiveQtImage::SharedState::~SharedState()
+{
+    residentBytes -= image.sizeInBytes();
+    encodedBytes -= encodedData.size();
+}
+
+RiveQtImage::RiveQtImage(const QByteArray &encodedData)
+    : m_state(std::make_shared<SharedState>())
+    , m_id(nextImageId++)
+{
+    m_state->encodedData = encodedData;
+    encodedBytes += encodedData.size();
+
+    QBuffer buffer;
+    buffer.setData(encodedData);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer);
+    QSize size = reader.size();
+
+    if (!size.isValid()) {
+        // the format cannot tell the size without decoding, so decode it right away
+        qCDebug(rqqpRendering) << "Image size unknown before decoding, decoding eagerly.";
+        m_state->image = QImage::fromData(encodedData);
+        m_state->decodeFailed = m_state->image.isNull();
+        markUsed(m_state.get());
+        decodedBytes += m_state->image.sizeInBytes();
+        residentBytes += m_state->image.sizeInBytes();
+        size = m_state->image.size();
+    }
+
+    m_Width = size.width();
+    m_Height = size.height();
+
+    registerState(m_state);
+}
+
+RiveQtImage::RiveQtImage(const QImage &image)
+    : m_state(std::make_shared<SharedState>())
+    , m_id(nextImageId++)
+{
+    m_state->image = image;
+    m_state->evictable = false;
+    decodedBytes += image.sizeInBytes();
+    residentBytes += image.sizeInBytes();
+
+    m_Width = image.width();
+    m_Height = image.height();
+}
+
+RiveQtImage::~RiveQtImage() { }
+
+QImage RiveQtImage::image() const
+{
+    QMutexLocker locker(&m_state->mutex);
+
+    markUsed(m_state.get());
+
+    if (!m_state->image.isNull() || m_state->decoding || m_state->decodeFailed || m_state->encodedData.isEmpty()) {
+        return m_state->image;
+    }
+
+    m_state->decoding = true;
+    pendingDecodeCount++;
+
+    // the job keeps the state alive, the image itself might be gone once decoding is done
+    std::shared_ptr<SharedState> state = m_state;
+    QThreadPool::globalInstance()->start([state]() { decode(state); });
+
+    return QImage();
+}
+
+void RiveQtImage::evict()
+{
+    QMutexLocker locker(&m_state->mutex);
+
+    if (!m_state->evictable || m_state->image.isNull()) {
+        return;
+    }
+
+    residentBytes -= m_state->image.sizeInBytes();
+    m_state->image = QImage();
+}
+
+RiveQtImage::Statistics RiveQtImage::statistics()
+{
+    Statistics statistics;
+    statistics.encodedBytes = encodedBytes;
+    statistics.decodedBytes = decodedBytes;
+    statistics.residentBytes = residentBytes;
+    statistics.pendingDecodes = pendingDecodeCount;
+    return statistics;
+}
+
+void RiveQtImage::setResidentBudget(qint64 bytes)
+{
+    residentBudget = bytes;
+
+    if (bytes > 0 && residentBytes > bytes) {
+        trimResidentBytes(bytes);
+    }
+}
+
+void RiveQtImage::trimResidentBytes(qint64 maxBytes)
+{
+    struct Candidate
+    {
+        std::shared_ptr<SharedState> state;
+        quint64 lastUsed;
+    };
+
+    // images in use stay resident even if that exceeds maxBytes, they would just be decoded again one after the other
+    const qint64 inUseSince = usageTime() - inUseMilliseconds;
+
+    QVector<Candidate> candidates;
+    {
+        QMutexLocker locker(&registryMutex);
+        for (const auto &entry : qAsConst(registry)) {
+            if (auto state = entry.lock()) {
+                QMutexLocker stateLocker(&state->mutex);
+                if (!state->image.isNull() && state->lastUsedTime < inUseSince) {
+                    candidates.append({ state, state->lastUsed });
+                }
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) { return a.lastUsed < b.lastUsed; });
+
+    for (const Candidate &candidate : qAsConst(candidates)) {
+        if (residentBytes <= maxBytes) {
+            break;
+        }
+
+        QMutexLocker locker(&candidate.state->mutex);
+        // skip images that got used since we collected them
+        if (candidate.state->lastUsed != candidate.lastUsed || candidate.state->image.isNull()) {
+            continue;
+        }
+
+        residentBytes -= candidate.state->image.sizeInBytes();
+        candidate.state->image = QImage();
+    }
+
+    qCDebug(rqqpRendering) << "Trimmed resident image pixels to" << residentBytes << "bytes";
+}
+
+quint64 RiveQtImage::generation() const
+{
+    return m_state->generation;
+}
+
+void RiveQtImage::waitForDecode(const std::shared_ptr<RiveQtDecodeListener> &listener) const
+{
+    QMutexLocker locker(&m_state->mutex);
+
+    markUsed(m_state.get());
+
+    if (!m_state->image.isNull() || m_state->decodeFailed || m_state->encodedData.isEmpty()) {
+        return;
+    }
+
+    // a frame is recorded again and again while the image decodes, the listener is only kept once
+    auto &listeners = m_state->decodeListeners;
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](const auto &entry) { return entry.expired(); }),
+                    listeners.end());
+    for (const auto &entry : qAsConst(listeners)) {
+        if (entry.lock() == listener) {
+            return;
+        }
+    }
+    listeners.append(listener);
+}
+
+RiveQtDecodeListener::RiveQtDecodeListener(QObject *receiver, std::function<void()> callback)
+    : m_receiver(receiver)
+    , m_callback(std::move(callback))
+{
+}
+
+void RiveQtDecodeListener::detach()
+{
+    QMutexLocker locker(&m_mutex);
+    m_receiver = nullptr;
+}
+
+void RiveQtDecodeListener::notify()
+{
+    // the receiver can not be destroyed while we hold the lock, it has to detach first
+    QMutexLocker locker(&m_mutex);
+    if (m_receiver) {
+        QMetaObject::invokeMethod(m_receiver, m_callback, Qt::QueuedConnection);
+    }
+}
+
+int RiveQtImage::pendingDecodes()
+{
+    return pendingDecodeCount;
+}
@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+
+class QObject;
+
+// Wakes up the owner of a frame that skipped an image while it was still decoding.
+//
+// Recording happens on the gui or the render thread, so images only keep weak references to listeners.
+// The owner detaches the listener before it is destroyed, nothing gets queued to it afterwards.
+class RiveQtDecodeListener
+{
+public:
+    // callback is queued to the thread of receiver
+    RiveQtDecodeListener(QObject *receiver, std::function<void()> callback);
+
+    void detach();
+    void notify();
+
+private:
+    QMutex m_mutex;
+    QObject *m_receiver { nullptr };
+    std::function<void()> m_callback;
+};
+
+#include <rive/renderer.hpp>
+
+// Image of a rive file that keeps the encoded data and decodes the pixels on first use.
+//
+// Decoding runs on the global thread pool, decoded pixels can be evicted at any time
+// and are decoded again the next time the image gets drawn.
+class RiveQtImage : public rive::RenderImage
+{
+public:
+    struct Statistics
+    {
+        qint64 encodedBytes { 0 }; // compressed data held by all living images
+        qint64 decodedBytes { 0 }; // pixels decoded so far, including pixels that got evicted again
+        qint64 residentBytes { 0 }; // pixels held in memory right now
+        int pendingDecodes { 0 };
+    };
+
+    // takes the encoded data, only the header is read to know the size of the image
+    explicit RiveQtImage(const QByteArray &encodedData);
+    // already decoded pixels, those are never evicted since there is nothing to decode them from
+    explicit RiveQtImage(const QImage &image);
+    ~RiveQtImage() override;
+
+    bool isValid() const { return m_Width > 0 && m_Height > 0; }
+
+    // unique for the lifetime of the process, other than the address of the image
+    quint64 id() const { return m_id; }
+
+    // Returns the decoded pixels. If they are not resident, decoding gets started in the background
+    // and a null image is returned, the image has to be skipped for this frame then.
+    // Data that failed to decode once is not decoded again, the image stays null.
+    QImage image() const;
+
+    // In case the pixels are not resident, listener gets notified once the next decode of the image finished.
+    // Counts as a use of the image, trimming does not evict it before the recorded frame got drawn.
+    void waitForDecode(const std::shared_ptr<RiveQtDecodeListener> &listener) const;
+
+    // Bumped whenever a decode finished. Draws of this image look different afterwards,
+    // so anything caching the rendered result has to take it into account.
+    quint64 generation() const;
+
+    // drops the decoded pixels, they get decoded again once the image is drawn the next time
+    void evict();
+
+    static Statistics statistics();
+
+    // Upper limit for resident pixels in bytes, the least recently used images get evicted once a decode exceeds it.
+    // Images drawn within the last half second are never evicted by trimming, the limit can be exceeded by them.
+    // 0 means no limit.
+    static void setResidentBudget(qint64 bytes);
+    static void trimResidentBytes(qint64 maxBytes);
+
+    // Decodes still running, each of them brings an image that got skipped so far.
+    static int pendingDecodes();
+
+
+    struct SharedState;
+
+private:
+    std::shared_ptr<SharedState> m_state;
+    quint64 m_id { 0 };
+};
@@ -351,15 +351,15 @@ void RiveQtOpenGLRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *p
 
     glEnable(GL_BLEND);
     {
-        QVector<QVector<QVector2D>> pathData;
+        qtPath->setDeviceScale(RiveQtUtils::scaleFactor(transform()));
 
         if (qtPaint->paintStyle() == rive::RenderPaintStyle::fill) {
-            pathData = qtPath->toVertices();
+            qtPath->setFillMethod(m_fillMethod);
         }
 
-        if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke) {
-            pathData = qtPath->toVerticesLine(qtPaint->pen());
-        }
+        const RiveQtPathGeometry &pathData = qtPaint->paintStyle() == rive::RenderPaintStyle::stroke
+            ? qtPath->toVerticesLine(qtPaint->pen(), qtPaint->strokeGeneration())
+            : qtPath->toVertices();
 
         // Check if the alphaMaskFramebuffer is valid
         if (m_alphaMaskFramebuffer && m_alphaMaskFramebuffer->isValid()) {
@@ -398,22 +398,15 @@ void RiveQtOpenGLRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *p
         vbo.bind();
         vbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
 
-        int maxVerticesSize = 0;
-        for (const auto &segment : qAsConst(pathData)) {
-            maxVerticesSize = qMax(maxVerticesSize, segment.size());
-        }
-        vbo.allocate(maxVerticesSize * sizeof(QVector2D));
+        // all sub paths are uploaded at once, each one is drawn from its offset
+        vbo.allocate(pathData.vertices.constData(), pathData.vertexCount() * sizeof(QVector2D));
 
         m_pathShaderProgram->bind();
 
         int posAttr = m_pathShaderProgram->attributeLocation("a_position");
         m_pathShaderProgram->enableAttributeArray(posAttr);
 
-        for (const auto &segment : qAsConst(pathData)) {
-            QVector2D *vboData = static_cast<QVector2D *>(vbo.map(QOpenGLBuffer::WriteOnly));
-            std::copy(segment.constBegin(), segment.constEnd(), vboData);
-            vbo.unmap();
-
+        for (int subPath = 0; subPath < pathData.subPathCount(); ++subPath) {
             m_pathShaderProgram->setUniformValue("u_useAlphaMask", m_IsClippingDirty);
             m_pathShaderProgram->setUniformValue("u_alphaMaskTexture", 0);
 
@@ -441,9 +434,9 @@ void RiveQtOpenGLRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *p
             m_pathShaderProgram->setAttributeBuffer(posAttr, GL_FLOAT, 0, 2, 0);
 
             if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke) {
-                glDrawArrays(GL_TRIANGLE_STRIP, 0, segment.count());
+                glDrawArrays(GL_TRIANGLE_STRIP, pathData.subPaths.at(subPath), pathData.subPathSize(subPath));
             } else {
-                glDrawArrays(GL_TRIANGLES, 0, segment.count());
+                glDrawArrays(GL_TRIANGLES, pathData.subPaths.at(subPath), pathData.subPathSize(subPath));
             }
         }
 
@@ -477,11 +470,12 @@ void RiveQtOpenGLRenderer::clipPath(rive::RenderPath *path)
 
     QColor outlineColor(255, 0, 0, 255); // Red color for the outlines
 
-    QVector<QVector<QVector2D>> pathData;
+    qtPath->setFillMethod(m_fillMethod);
+    qtPath->setDeviceScale(RiveQtUtils::scaleFactor(transform()));
+    const RiveQtPathGeometry &pathData = qtPath->toVertices();
 
-    pathData = qtPath->toVertices();
-
-    for (const auto &segment : qAsConst(pathData)) {
+    // the fill is a plain triangle list, all sub paths are drawn at once
+    if (!pathData.isEmpty()) {
         QOpenGLVertexArrayObject vao;
         vao.create();
         vao.bind();
@@ -489,7 +483,7 @@ void RiveQtOpenGLRenderer::clipPath(rive::RenderPath *path)
         QOpenGLBuffer vbo(QOpenGLBuffer::VertexBuffer);
         vbo.create();
         vbo.bind();
-        vbo.allocate(segment.constData(), segment.count() * sizeof(QVector2D));
+        vbo.allocate(pathData.vertices.constData(), pathData.vertexCount() * sizeof(QVector2D));
 
         // Enable the shader program
         m_pathShaderProgram->bind();
@@ -538,7 +532,11 @@ void RiveQtOpenGLRenderer::drawImage(const rive::RenderImage *image, rive::Blend
     glEnable(GL_BLEND);
 
     const auto *riveImage = static_cast<const RiveQtImage *>(image);
-    const QImage &qImage = riveImage->image();
+    const QImage qImage = riveImage->image();
+    if (qImage.isNull()) {
+        glDisable(GL_BLEND);
+        return; // still decoding
+    }
     QOpenGLTexture texture(qImage);
 
     // Bind the texture
@@ -582,7 +580,10 @@ void RiveQtOpenGLRenderer::drawImageMesh(const rive::RenderImage *image, rive::r
                                          rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16,
                                          rive::BlendMode blendMode, float opacity)
 {
-    const QImage &qImage = static_cast<const RiveQtImage *>(image)->image();
+    const QImage qImage = static_cast<const RiveQtImage *>(image)->image();
+    if (qImage.isNull()) {
+        return; // still decoding
+    }
     QOpenGLTexture texture(qImage);
 
     // Bind the texture
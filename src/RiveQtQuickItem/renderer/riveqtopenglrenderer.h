@@ -49,6 +49,11 @@ public:
     void updateViewportSize();
     void updateProjectionMatrix(const QMatrix4x4 &projMatrix);
     void updateModelMatrix(const QMatrix4x4 &modelMatrix);
+    void setFillMethod(const RiveRenderSettings::FillMethod fillMethod)
+    {
+        // stencil and cover is not implemented here
+        m_fillMethod = fillMethod == RiveRenderSettings::StencilAndCover ? RiveRenderSettings::Tessellator : fillMethod;
+    }
 
 private:
     void setupBlendMode(rive::BlendMode blendMode);
@@ -75,6 +80,7 @@ private:
     QOpenGLBuffer m_meshIndexBuffer;
 
     QMatrix4x4 m_projectionMatrix;
+    RiveRenderSettings::FillMethod m_fillMethod { RiveRenderSettings::Tessellator };
     // QMatrix4x4 m_modelMatrix the modelMatrix is stored as base of our renderState!
 
     qreal m_width { 0 };
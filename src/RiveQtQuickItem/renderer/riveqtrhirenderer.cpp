@@ -11,13 +11,33 @@
 #include <QVector4D>
 #include <QSGRenderNode>
 #include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 #include <private/qtriangulator_p.h>
 
 #include "rqqplogging.h"
 #include "renderer/riveqtrhirenderer.h"
+#include "renderer/riveqtutils.h"
+#include "rhi/texturecache.h"
 #include "rhi/texturetargetnode.h"
 
+namespace {
+// Tessellation has a pool of its own, it would wait behind image decodes on the global one otherwise.
+// The render thread works on the jobs as well, it does not need a thread of the pool.
+QThreadPool *tessellationPool()
+{
+    static QThreadPool *pool = []() {
+        auto *threadPool = new QThreadPool();
+        threadPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return threadPool;
+    }();
+    return pool;
+}
+}
+
 RiveQtRhiRenderer::RiveQtRhiRenderer(QQuickWindow *window)
     : rive::Renderer()
     , m_window(window)
@@ -30,6 +50,10 @@ RiveQtRhiRenderer::~RiveQtRhiRenderer()
     for (TextureTargetNode *textureTargetNode : m_renderNodes) {
         delete textureTargetNode;
     }
+
+    releaseRenderTargets();
+
+    delete m_vertexBufferCache;
 }
 
 void RiveQtRhiRenderer::save()
@@ -67,22 +91,46 @@ void RiveQtRhiRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *pain
     RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
     RiveQtPaint *qtPaint = static_cast<RiveQtPaint *>(paint);
 
-    QVector<QVector<QVector2D>> pathData;
+    // stencil and cover uses the stencil buffer of the pass itself, clipped fills need real triangles
+    const bool stencilFill = qtPaint->paintStyle() == rive::RenderPaintStyle::fill && m_fillMethod == RiveRenderSettings::StencilAndCover
+        && !m_rhiRenderStack.back().clipping;
 
-    if (qtPaint->paintStyle() == rive::RenderPaintStyle::fill) {
-        pathData = qtPath->toVertices();
-    }
+    // the geometry is only recorded here, all paths of the frame get tessellated together in finishDrawing
+    PendingGeometry pending;
+    pending.path = qtPath;
+    pending.deviceScale = m_viewScale * RiveQtUtils::scaleFactor(transformMatrix());
+    pending.transform = transformMatrix();
 
     if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke) {
-        pathData = qtPath->toVerticesLine(qtPaint->pen());
+        // the centerline does not depend on the pen, animated stroke widths do not flatten the path again
+        pending.type = expandsStrokesOnGpu() ? PendingGeometry::Centerline : PendingGeometry::Stroke;
+        pending.pen = qtPaint->pen();
+        pending.strokeGeneration = qtPaint->strokeGeneration();
+    } else {
+        pending.fillMethod = stencilFill ? RiveRenderSettings::StencilAndCover : triangulatedFillMethod();
     }
+    pending.key = geometryKey(pending, qtPaint);
 
     QColor color = qtPaint->color();
 
-    TextureTargetNode *node = getRiveDrawTargetNode();
-
     m_rhiRenderStack.back().opacity = qtPaint->opacity();
 
+    if (isBatchable(qtPaint)) {
+        if (!m_batchNode) {
+            m_batchNode = getRiveDrawTargetNode();
+        }
+        pending.node = m_batchNode;
+        pending.batched = true;
+        pending.color = color;
+        pending.opacity = currentOpacity();
+        m_pendingGeometries.append(pending);
+        return;
+    }
+
+    m_batchNode = nullptr;
+
+    TextureTargetNode *node = getRiveDrawTargetNode();
+
     // opacity is used to apply the strength of the blending effect/layer, though
     // for some reason it looks like it failes in case gradients are used
     // look at that later
@@ -102,45 +150,140 @@ void RiveQtRhiRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *pain
     drawClipping->updateGeometry(m_rhiRenderStack.back().clippingGeometry, QMatrix4x4());
 #endif
 
-    node->updateClippingGeometry(m_rhiRenderStack.back().clippingGeometry);
+    node->updateClippingGeometry(m_rhiRenderStack.back().clipping, m_rhiRenderStack.back().clippingGeometry);
+    node->setStencilFill(stencilFill, qtPath->toQPainterPath().fillRule());
 
-    node->updateGeometry(pathData, transformMatrix());
+    pending.node = node;
+    m_pendingGeometries.append(pending);
 
     m_rhiRenderStack.back().stackNodes.append(node);
 }
 
+void RiveQtRhiRenderer::finishDrawing()
+{
+    // All draws of a path are tessellated by the same thread, a path is not thread safe.
+    // Draws of the same path are chained, a job is the first draw of every path.
+    m_tessellationJobs.resize(0);
+    m_lastDrawOfPath.clear();
+    for (int i = 0; i < m_pendingGeometries.size(); ++i) {
+        RiveQtPath *path = m_pendingGeometries.at(i).path;
+        auto last = m_lastDrawOfPath.find(path);
+        if (last == m_lastDrawOfPath.end()) {
+            m_tessellationJobs.append(i);
+            m_lastDrawOfPath.insert(path, i);
+        } else {
+            m_pendingGeometries[last.value()].nextOfPath = i;
+            last.value() = i;
+        }
+    }
+
+    // Every draw keeps its own geometry, a path drawn at two scales or with two fill methods is not touched again afterwards.
+    // Draws of different paths never share an element, so the jobs can write into the vector concurrently.
+    PendingGeometry *pendingGeometries = m_pendingGeometries.data();
+    const auto tessellate = [pendingGeometries](int first) {
+        for (int i = first; i >= 0; i = pendingGeometries[i].nextOfPath) {
+            PendingGeometry &pending = pendingGeometries[i];
+            pending.geometry = pendingGeometry(pending);
+            pending.generation = pending.path->generation();
+        }
+    };
+
+    // the render thread takes part in the work as well, paths with an up to date geometry return right away
+    if (m_tessellationJobs.size() > 1) {
+        QtConcurrent::blockingMap(tessellationPool(), m_tessellationJobs, [&tessellate](int &first) { tessellate(first); });
+    } else {
+        for (int first : qAsConst(m_tessellationJobs)) {
+            tessellate(first);
+        }
+    }
+
+    // In drawing order, batches are appended in the right order and paths drawn differently twice get the right geometry.
+    // Those draws have different keys, each of them uploads into a vertex buffer of its own.
+    for (const PendingGeometry &pending : qAsConst(m_pendingGeometries)) {
+        const RiveQtPathGeometry &geometry = pending.geometry;
+        const quint64 generation = pending.generation;
+
+        if (pending.batched) {
+            pending.node->appendBatchGeometry(pending.key, generation, geometry, pending.transform, pending.color, pending.opacity);
+        } else if (pending.type == PendingGeometry::Centerline) {
+            pending.node->updateStrokeGeometry(pending.key, generation, geometry, pending.transform, pending.pen);
+        } else {
+            pending.node->updateGeometry(pending.key, generation, geometry, pending.transform);
+        }
+    }
+
+    m_pendingGeometries.resize(0);
+}
+
+const RiveQtPathGeometry &RiveQtRhiRenderer::pendingGeometry(const PendingGeometry &pending)
+{
+    RiveQtPath *path = pending.path;
+    path->setDeviceScale(pending.deviceScale);
+
+    switch (pending.type) {
+    case PendingGeometry::Centerline:
+        return path->toStrokeCenterline();
+    case PendingGeometry::Stroke:
+        return path->toVerticesLine(pending.pen, pending.strokeGeneration);
+    case PendingGeometry::Fill:
+    default:
+        path->setFillMethod(pending.fillMethod);
+        return path->toVertices();
+    }
+}
+
 void RiveQtRhiRenderer::clipPath(rive::RenderPath *path)
 {
+    // draws after this one are clipped and cannot join the current batch
+    m_batchNode = nullptr;
+
     // alternativly we could save the paths + transform to the node and
     // draw each one by one to the stencil buffer
     // -> I would guess that would be faster
     RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
-    auto pathVertices = qtPath->toVertices();
-
-    for (auto &path : pathVertices) {
-        for (auto &point : path) {
-            QVector4D vec4(point, 0.0f, 1.0f);
-            vec4 = transformMatrix() * vec4;
-            point = vec4.toVector2D();
-        }
+    qtPath->setFillMethod(triangulatedFillMethod());
+    qtPath->setDeviceScale(m_viewScale * RiveQtUtils::scaleFactor(transformMatrix()));
+    const RiveQtPathGeometry &pathVertices = qtPath->toVertices();
+
+    // transformed into the memory of the previous clip, no allocation once it is large enough
+    // an empty path does not clip, a path without any area clips everything
+    m_rhiRenderStack.back().clipping = !qtPath->toQPainterPath().isEmpty();
+    QVector<QVector2D> &clippingGeometry = m_rhiRenderStack.back().clippingGeometry;
+    clippingGeometry.resize(pathVertices.vertexCount());
+
+    const QMatrix4x4 &transform = transformMatrix();
+    for (int i = 0; i < pathVertices.vertexCount(); ++i) {
+        QVector4D vec4(pathVertices.vertices.at(i), 0.0f, 1.0f);
+        vec4 = transform * vec4;
+        clippingGeometry[i] = vec4.toVector2D();
     }
 
-    m_rhiRenderStack.back().clippingGeometry = pathVertices;
-
     for (TextureTargetNode *textureTargetNode : m_rhiRenderStack.back().stackNodes) {
-        textureTargetNode->updateClippingGeometry(m_rhiRenderStack.back().clippingGeometry);
+        textureTargetNode->updateClippingGeometry(m_rhiRenderStack.back().clipping, m_rhiRenderStack.back().clippingGeometry);
     }
 }
 
 void RiveQtRhiRenderer::drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity)
 {
+    const RiveQtImage *riveQtImage = static_cast<const RiveQtImage *>(image);
+    // the texture outlives evicted pixels, those are only needed to upload it
+    QImage qImage;
+    if (!TextureCache::forWindow(m_window)->touch(riveQtImage->id())) {
+        qImage = riveQtImage->image();
+        if (qImage.isNull()) {
+            return; // still decoding
+        }
+    }
+
+    m_batchNode = nullptr;
+
     TextureTargetNode *node = getRiveDrawTargetNode();
 
     m_rhiRenderStack.back().opacity = opacity;
     node->setOpacity(currentOpacity()); // inherit the opacity from the parent
     node->setBlendMode(blendMode);
 
-    node->setTexture(static_cast<const RiveQtImage *>(image)->image(), //
+    node->setTexture(riveQtImage->id(), qImage, QSize(riveQtImage->width(), riveQtImage->height()), //
                      nullptr, nullptr, nullptr,
                      transformMatrix()); //
 
@@ -151,7 +294,7 @@ void RiveQtRhiRenderer::drawImage(const rive::RenderImage *image, rive::BlendMod
     drawClipping->updateGeometry(m_rhiRenderStack.back().clippingGeometry, QMatrix4x4());
 #endif
 
-    node->updateClippingGeometry(m_rhiRenderStack.back().clippingGeometry);
+    node->updateClippingGeometry(m_rhiRenderStack.back().clipping, m_rhiRenderStack.back().clippingGeometry);
     m_rhiRenderStack.back().stackNodes.append(node);
 }
 
@@ -159,6 +302,18 @@ void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<
                                       rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16,
                                       rive::BlendMode blendMode, float opacity)
 {
+    const RiveQtImage *riveQtImage = static_cast<const RiveQtImage *>(image);
+    // the texture outlives evicted pixels, those are only needed to upload it
+    QImage qImage;
+    if (!TextureCache::forWindow(m_window)->touch(riveQtImage->id())) {
+        qImage = riveQtImage->image();
+        if (qImage.isNull()) {
+            return; // still decoding
+        }
+    }
+
+    m_batchNode = nullptr;
+
     TextureTargetNode *node = getRiveDrawTargetNode();
 
     m_rhiRenderStack.back().opacity = opacity;
@@ -166,7 +321,7 @@ void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<
     node->setOpacity(currentOpacity()); // inherit the opacity from the parent
     node->setBlendMode(blendMode);
 
-    node->setTexture(static_cast<const RiveQtImage *>(image)->image(), //
+    node->setTexture(riveQtImage->id(), qImage, QSize(riveQtImage->width(), riveQtImage->height()), //
                      static_cast<RiveQtBufferF32 *>(vertices_f32.get()), //
                      static_cast<RiveQtBufferF32 *>(uvCoords_f32.get()), //
                      static_cast<RiveQtBufferU16 *>(indices_u16.get()),
@@ -179,15 +334,184 @@ void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<
   drawClipping->updateGeometry(m_rhiRenderStack.back().clippingGeometry, QMatrix4x4());
 #endif
 
-    node->updateClippingGeometry(m_rhiRenderStack.back().clippingGeometry);
+    node->updateClippingGeometry(m_rhiRenderStack.back().clipping, m_rhiRenderStack.back().clippingGeometry);
     m_rhiRenderStack.back().stackNodes.append(node);
 }
 
 void RiveQtRhiRenderer::render(QRhiCommandBuffer *cb)
 {
-    for (TextureTargetNode *textureTargetNode : m_renderNodes) {
+    QSGRendererInterface *renderInterface = m_window->rendererInterface();
+    QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+    Q_ASSERT(rhi);
+
+    if (!m_displayBuffer) {
+        return;
+    }
+
+    // The display buffer can be larger than the item, the item is drawn into its top left corner.
+    const QSize displayBufferSize = m_displayBuffer->pixelSize();
+    const QRect contentRect = QRect(QPoint(0, 0), m_contentSize) & QRect(QPoint(0, 0), displayBufferSize);
+
+    // Partial redraws keep the content outside of the damage and draw everything scissored to it.
+    // Shader blends copy and blend the whole display buffer, with those the whole frame is drawn again.
+    QRect damage = m_damageAll ? contentRect : (m_damage & contentRect);
+    m_damage = QRect();
+    m_damageAll = false;
+
+    if (damage.isEmpty()) {
+        return;
+    }
+
+    bool partialRedraw = damage != contentRect && 2 * damage.width() * damage.height() < contentRect.width() * contentRect.height();
+    for (TextureTargetNode *textureTargetNode : qAsConst(m_renderNodes)) {
+        if (!textureTargetNode->isRecycled() && textureTargetNode->needsShaderBlending()) {
+            partialRedraw = false;
+            break;
+        }
+    }
+    if (!partialRedraw) {
+        damage = contentRect;
+    }
+
+    // viewports and scissors have their origin at the bottom left
+    const QRect viewport(0, displayBufferSize.height() - contentRect.height(), contentRect.width(), contentRect.height());
+    const QRect scissor(damage.x(), displayBufferSize.height() - damage.y() - damage.height(), damage.width(), damage.height());
+
+    createRenderTargets(rhi);
+
+    if (!m_vertexBufferCache) {
+        m_vertexBufferCache = new VertexBufferCache(rhi);
+    }
+    m_vertexBufferCache->beginFrame();
+
+    // all updates of all nodes are submitted together with the first pass
+    QRhiResourceUpdateBatch *resourceUpdates = rhi->nextResourceUpdateBatch();
+    for (TextureTargetNode *textureTargetNode : qAsConst(m_renderNodes)) {
+        textureTargetNode->setTargetArea(viewport, scissor);
+        textureTargetNode->prepareRender(resourceUpdates, m_renderPassDescriptor, m_vertexBufferCache);
+    }
+
+    if (partialRedraw) {
+        // a pass can only clear the whole target, the damage is cleared by uploading transparent pixels before the first pass
+        if (m_clearImage.width() < damage.width() || m_clearImage.height() < damage.height()) {
+            m_clearImage = QImage(damage.size().expandedTo(m_clearImage.size()), QImage::Format_RGBA8888_Premultiplied);
+            m_clearImage.fill(Qt::transparent);
+        }
+
+        // the first row of the texture is the bottom of the framebuffer if its y axis points up
+        QRhiTextureSubresourceUploadDescription clearDescription(m_clearImage);
+        clearDescription.setSourceSize(damage.size());
+        clearDescription.setDestinationTopLeft(QPoint(damage.x(), rhi->isYUpInFramebuffer() ? scissor.y() : damage.y()));
+        resourceUpdates->uploadTexture(m_displayBuffer, QRhiTextureUploadDescription({ 0, 0, clearDescription }));
+    }
+
+    m_renderPassCount = 0;
+    bool passRecording = false;
+    bool displayBufferCleared = partialRedraw;
+
+    const auto beginPass = [&]() {
+        cb->beginPass(displayBufferCleared ? m_preservingRenderTarget : m_clearingRenderTarget, QColor(0, 0, 0, 0), { 1.0f, 0 },
+                      resourceUpdates);
+        resourceUpdates = nullptr;
+        passRecording = true;
+        displayBufferCleared = true;
+        m_renderPassCount++;
+    };
+
+    for (TextureTargetNode *textureTargetNode : qAsConst(m_renderNodes)) {
+        if (textureTargetNode->isRecycled()) {
+            continue;
+        }
+
+        if (textureTargetNode->needsShaderBlending()) {
+            // blending reads the display buffer, so everything before has to be finished
+            if (!passRecording && !displayBufferCleared) {
+                beginPass();
+            }
+            if (passRecording) {
+                cb->endPass();
+                passRecording = false;
+            }
+
+            textureTargetNode->renderShaderBlend(cb);
+            m_renderPassCount += 2;
+            continue;
+        }
+
+        if (!passRecording) {
+            beginPass();
+        }
+
         textureTargetNode->render(cb);
     }
+
+    // an empty frame still needs to clear what was drawn before and to submit the updates
+    if (resourceUpdates) {
+        beginPass();
+    }
+
+    if (passRecording) {
+        cb->endPass();
+    }
+
+    qCDebug(rqqpRendering) << "Render passes this frame:" << m_renderPassCount << "damaged area:" << damage;
+}
+
+void RiveQtRhiRenderer::createRenderTargets(QRhi *rhi)
+{
+    if (!m_stencilBuffer) {
+        m_stencilBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, m_displayBuffer->pixelSize(), 1);
+        m_stencilBuffer->create();
+    }
+
+    if (!m_clearingRenderTarget) {
+        QRhiColorAttachment colorAttachment(m_displayBuffer);
+        QRhiTextureRenderTargetDescription desc(colorAttachment);
+        desc.setDepthStencilBuffer(m_stencilBuffer);
+        m_clearingRenderTarget = rhi->newTextureRenderTarget(desc);
+
+        m_renderPassDescriptor = m_clearingRenderTarget->newCompatibleRenderPassDescriptor();
+        m_clearingRenderTarget->setRenderPassDescriptor(m_renderPassDescriptor);
+        m_clearingRenderTarget->create();
+    }
+
+    if (!m_preservingRenderTarget) {
+        QRhiColorAttachment colorAttachment(m_displayBuffer);
+        QRhiTextureRenderTargetDescription desc(colorAttachment);
+        desc.setDepthStencilBuffer(m_stencilBuffer);
+        m_preservingRenderTarget = rhi->newTextureRenderTarget(desc, QRhiTextureRenderTarget::PreserveColorContents);
+
+        // both targets share formats and attachments, one descriptor fits both
+        m_preservingRenderTarget->setRenderPassDescriptor(m_renderPassDescriptor);
+        m_preservingRenderTarget->create();
+    }
+}
+
+void RiveQtRhiRenderer::releaseRenderTargets()
+{
+    if (m_preservingRenderTarget) {
+        m_preservingRenderTarget->destroy();
+        delete m_preservingRenderTarget;
+        m_preservingRenderTarget = nullptr;
+    }
+
+    if (m_clearingRenderTarget) {
+        m_clearingRenderTarget->destroy();
+        delete m_clearingRenderTarget;
+        m_clearingRenderTarget = nullptr;
+    }
+
+    if (m_renderPassDescriptor) {
+        m_renderPassDescriptor->destroy();
+        delete m_renderPassDescriptor;
+        m_renderPassDescriptor = nullptr;
+    }
+
+    if (m_stencilBuffer) {
+        m_stencilBuffer->destroy();
+        delete m_stencilBuffer;
+        m_stencilBuffer = nullptr;
+    }
 }
 
 TextureTargetNode *RiveQtRhiRenderer::getRiveDrawTargetNode()
@@ -211,6 +535,55 @@ TextureTargetNode *RiveQtRhiRenderer::getRiveDrawTargetNode()
     return pathNode;
 }
 
+bool RiveQtRhiRenderer::isBatchable(RiveQtPaint *qtPaint) const
+{
+    // gradients are evaluated in the local coordinates of the path and clipping needs the stencil of the node,
+    // so only plain colors without clipping can share a draw call
+    // stencil and cover fills are no triangles that could be merged
+    if (qtPaint->paintStyle() == rive::RenderPaintStyle::fill && m_fillMethod == RiveRenderSettings::StencilAndCover) {
+        return false;
+    }
+    // neither are centerlines of strokes
+    if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke && expandsStrokesOnGpu()) {
+        return false;
+    }
+
+    return qtPaint->blendMode() == rive::BlendMode::srcOver && qtPaint->color().isValid()
+        && !m_rhiRenderStack.back().clipping;
+}
+
+bool RiveQtRhiRenderer::expandsStrokesOnGpu() const
+{
+    QSGRendererInterface *renderInterface = m_window->rendererInterface();
+    QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+    return rhi && rhi->isFeatureSupported(QRhi::Instancing);
+}
+
+RiveRenderSettings::FillMethod RiveQtRhiRenderer::triangulatedFillMethod() const
+{
+    return m_fillMethod == RiveRenderSettings::StencilAndCover ? RiveRenderSettings::Tessellator : m_fillMethod;
+}
+
+VertexBufferCache::Key RiveQtRhiRenderer::geometryKey(const PendingGeometry &pending, RiveQtPaint *qtPaint) const
+{
+    VertexBufferCache::Key key;
+    key.pathId = pending.path->id();
+    key.tolerance = pending.path->toleranceForDeviceScale(pending.deviceScale);
+
+    if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke) {
+        key.stroke = true;
+        if (expandsStrokesOnGpu()) {
+            return key; // the centerline is the same for every pen
+        }
+        key.penWidth = qtPaint->pen().widthF();
+        key.penStyle = uint(qtPaint->pen().joinStyle()) | uint(qtPaint->pen().capStyle());
+    } else {
+        key.fillMethod = uint(pending.fillMethod);
+    }
+
+    return key;
+}
+
 void RiveQtRhiRenderer::setProjectionMatrix(const QMatrix4x4 *projectionMatrix, const QMatrix4x4 *combinedMatrix)
 {
     m_projectionMatrix = *projectionMatrix;
@@ -225,12 +598,39 @@ void RiveQtRhiRenderer::updateViewPort(const QRectF &viewportRect, QRhiTexture *
         delete textureTargetNode;
     }
 
+    releaseRenderTargets();
+
+    m_batchNode = nullptr;
     m_viewportRect = viewportRect;
     m_displayBuffer = displayBuffer;
+    m_damageAll = true;
+}
+
+void RiveQtRhiRenderer::setViewportRect(const QRectF &viewportRect)
+{
+    m_viewportRect = viewportRect;
+    m_damageAll = true;
+
+    for (TextureTargetNode *textureTargetNode : qAsConst(m_renderNodes)) {
+        textureTargetNode->setBounds(viewportRect);
+    }
+}
+
+void RiveQtRhiRenderer::setContentSize(const QSize &contentSize)
+{
+    if (m_contentSize == contentSize) {
+        return;
+    }
+
+    m_contentSize = contentSize;
+    m_damageAll = true;
 }
 
 void RiveQtRhiRenderer::recycleRiveNodes()
 {
+    m_batchNode = nullptr;
+    m_pendingGeometries.resize(0); // in case the last frame was not finished
+
     for (TextureTargetNode *textureTargetNode : m_renderNodes) {
         textureTargetNode->recycle();
     }
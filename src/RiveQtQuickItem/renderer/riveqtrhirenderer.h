@@ -10,6 +10,8 @@
 #include <QBrush>
 #include <QPen>
 #include <QLinearGradient>
+#include <QHash>
+#include <QImage>
 
 #include <private/qrhi_p.h>
 
@@ -18,17 +20,20 @@
 
 #include "datatypes.h"
 #include "riveqtpath.h"
+#include "rhi/vertexbuffercache.h"
 
 class RhiSubPath;
 class QSGRenderNode;
 class TextureTargetNode;
+class RiveQtPaint;
 
 struct RhiRenderState
 {
     QMatrix4x4 transform;
     float opacity { 1.0 };
     RiveQtPath clipPath { 10u };
-    QVector<QVector<QVector2D>> clippingGeometry;
+    bool clipping { false }; // with an empty clippingGeometry everything is clipped away
+    QVector<QVector2D> clippingGeometry; // triangles in display buffer coordinates
     QVector<TextureTargetNode *> stackNodes;
 };
 
@@ -51,13 +56,77 @@ public:
 
     void setProjectionMatrix(const QMatrix4x4 *projectionMatrix, const QMatrix4x4 *combinedMatrix);
     void updateArtboardSize(const QSize &artboardSize) { m_artboardSize = artboardSize; }
+    // a new display buffer, all nodes get created again
     void updateViewPort(const QRectF &viewportRect, QRhiTexture *displayBuffer);
+    // The item got another size and is still drawn into the same display buffer, into its top left corner.
+    void setViewportRect(const QRectF &viewportRect);
+    // pixels of the display buffer the item is drawn into, the item is scaled to those
+    void setContentSize(const QSize &contentSize);
     void recycleRiveNodes();
+    void setFillMethod(const RiveRenderSettings::FillMethod fillMethod) { m_fillMethod = fillMethod; }
+    // scale from artboard units to pixels of the display buffer
+    void setViewScale(const float viewScale) { m_viewScale = viewScale; }
 
+    // Draws only record the geometry of their paths. Once the artboard is drawn, this tessellates the paths
+    // of all draws in parallel and hands the geometries to the nodes, before render.
+    void finishDrawing();
+
+    // Parts of the display buffer that changed since the last render(), in pixels with the origin at the top left.
+    // render() only clears and draws those, the rest keeps the content of the last frame.
+    void addDamage(const QRect &rect) { m_damage |= rect; }
+    void damageAll() { m_damageAll = true; }
+
+    // Records all nodes of the frame, as far as possible within a single render pass on the display buffer.
     void render(QRhiCommandBuffer *cb);
 
+    // number of render passes the last call to render() issued
+    int renderPassCount() const { return m_renderPassCount; }
+
 private:
+    struct PendingGeometry
+    {
+        enum Type
+        {
+            Fill,
+            Stroke,
+            Centerline // expanded to the stroke on the gpu
+        };
+
+        TextureTargetNode *node { nullptr };
+        RiveQtPath *path { nullptr };
+        VertexBufferCache::Key key;
+        Type type { Fill };
+        RiveRenderSettings::FillMethod fillMethod { RiveRenderSettings::Tessellator };
+        float deviceScale { 1.0f };
+        QPen pen;
+        quint64 strokeGeneration { 0 };
+        QMatrix4x4 transform;
+
+        // solid color draws appended to a batch node
+        bool batched { false };
+        QColor color;
+        float opacity { 1.0f };
+
+        int nextOfPath { -1 }; // next draw of the same path
+
+        // result of the tessellation, implicitly shared with the path
+        RiveQtPathGeometry geometry;
+        quint64 generation { 0 };
+    };
+
+    // brings the path up to date for the draw, returns its geometry
+    static const RiveQtPathGeometry &pendingGeometry(const PendingGeometry &pending);
+
     TextureTargetNode *getRiveDrawTargetNode();
+    bool isBatchable(RiveQtPaint *qtPaint) const;
+    // strokes are expanded from their centerline in the vertex shader, drawn instanced
+    bool expandsStrokesOnGpu() const;
+    // fill method for paths that need real triangles, stencil and cover cannot be used for clipping
+    RiveRenderSettings::FillMethod triangulatedFillMethod() const;
+    VertexBufferCache::Key geometryKey(const PendingGeometry &pending, RiveQtPaint *qtPaint) const;
+
+    void createRenderTargets(QRhi *rhi);
+    void releaseRenderTargets();
 
     const QMatrix4x4 &transformMatrix() const;
     float currentOpacity();
@@ -65,13 +134,40 @@ private:
     QVector<RhiRenderState> m_rhiRenderStack;
     QVector<TextureTargetNode *> m_renderNodes;
 
+    // node consecutive solid color draws get merged into, any other draw ends the batch to keep the drawing order
+    TextureTargetNode *m_batchNode { nullptr };
+
+    QVector<PendingGeometry> m_pendingGeometries; // draws of this frame, in drawing order
+    QVector<int> m_tessellationJobs; // first draw of every path
+    QHash<RiveQtPath *, int> m_lastDrawOfPath;
+
     QQuickWindow *m_window;
     QRhiTexture *m_displayBuffer;
 
+    // the display buffer with a stencil buffer shared by all nodes, once clearing it for the first pass of a frame
+    // and once preserving its content for passes following a shader blend
+    QRhiRenderBuffer *m_stencilBuffer { nullptr };
+    QRhiTextureRenderTarget *m_clearingRenderTarget { nullptr };
+    QRhiTextureRenderTarget *m_preservingRenderTarget { nullptr };
+    QRhiRenderPassDescriptor *m_renderPassDescriptor { nullptr };
+
+    int m_renderPassCount { 0 };
+
+    QRect m_damage;
+    bool m_damageAll { true };
+    QImage m_clearImage; // transparent pixels uploaded to clear a damaged area
+
+    RiveRenderSettings::FillMethod m_fillMethod { RiveRenderSettings::Tessellator };
+    float m_viewScale { 1.0f };
+
+    // path geometries on the gpu, kept across frames
+    VertexBufferCache *m_vertexBufferCache { nullptr };
+
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_combinedMatrix;
 
     QSize m_artboardSize;
     QRectF m_viewportRect;
+    QSize m_contentSize;
     QRectF m_riveRect;
 };
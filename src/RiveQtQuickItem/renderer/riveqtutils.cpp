@@ -4,6 +4,8 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <cmath>
+
 #include <QVector4D>
 #include <QMatrix4x4>
 
@@ -62,6 +64,12 @@ Qt::FillRule RiveQtUtils::riveFillRuleToQt(rive::FillRule fillRule)
     }
 }
 
+float RiveQtUtils::scaleFactor(const QMatrix4x4 &matrix)
+{
+    const float determinant = matrix(0, 0) * matrix(1, 1) - matrix(0, 1) * matrix(1, 0);
+    return std::sqrt(std::abs(determinant));
+}
+
 QPainterPath RiveQtUtils::transformPathWithMatrix4x4(const QPainterPath &path, const QMatrix4x4 &matrix)
 {
     QPainterPath transformedPath;
@@ -177,6 +185,18 @@ void RiveQtPaint::shader(rive::rcp<rive::RenderShader> shader)
     }
 }
 
+void RiveQtPaint::copyState(const RiveQtPaint &other)
+{
+    // the shader stays with the original, the brush already holds a copy of its gradient
+    m_paintStyle = other.m_paintStyle;
+    m_BlendMode = other.m_BlendMode;
+    m_color = other.m_color;
+    m_Brush = other.m_Brush;
+    m_Pen = other.m_Pen;
+    m_opacity = other.m_opacity;
+    m_strokeGeneration = other.m_strokeGeneration;
+}
+
 RiveQtLinearGradient::RiveQtLinearGradient(float x1, float y1, float x2, float y2, const rive::ColorInt *colors, const float *stops,
                                            size_t count)
     : m_gradient(x1, y1, x2, y2)
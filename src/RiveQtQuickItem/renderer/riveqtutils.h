@@ -19,6 +19,8 @@
 #include <rive/shapes/paint/stroke_join.hpp>
 #include <rive/math/mat2d.hpp>
 
+#include "riveqtimage.h"
+
 namespace RiveQtUtils {
 QColor riveColorToQt(rive::ColorInt value);
 Qt::PenJoinStyle riveStrokeJoinToQt(rive::StrokeJoin join);
@@ -26,6 +28,8 @@ Qt::PenCapStyle riveStrokeCapToQt(rive::StrokeCap cap);
 QMatrix4x4 riveMat2DToQt(const rive::Mat2D &riveMatrix);
 Qt::FillRule riveFillRuleToQt(rive::FillRule fillRule);
 QPainterPath transformPathWithMatrix4x4(const QPainterPath &path, const QMatrix4x4 &matrix);
+// average scale of the 2d part of the matrix, how much longer a unit line gets on average
+float scaleFactor(const QMatrix4x4 &matrix);
 }
 
 class RiveQtBufferU16 : public rive::RenderBuffer
@@ -79,22 +83,6 @@ private:
     std::vector<float> m_data;
 };
 
-class RiveQtImage : public rive::RenderImage
-{
-public:
-    RiveQtImage(const QImage &image)
-        : m_image(image)
-    {
-        m_Width = m_image.width();
-        m_Height = m_image.height();
-    }
-
-    const QImage &image() const { return m_image; }
-
-private:
-    QImage m_image;
-};
-
 class RiveQtShader : public rive::RenderShader
 {
 public:
@@ -149,9 +137,14 @@ public:
     const QBrush &brush() const { return m_Brush; }
     const QPen &pen() const { return m_Pen; }
     const float &opacity() const { return m_opacity; }
+    // changes every time rive invalidates the stroke, cached stroke geometries of older generations are outdated
+    quint64 strokeGeneration() const { return m_strokeGeneration; }
 
     virtual void shader(rive::rcp<rive::RenderShader> shader) override;
-    virtual void invalidateStroke() override {}; // maybe we need to reset something here
+    virtual void invalidateStroke() override { m_strokeGeneration++; }
+
+    // takes over everything renderers read from a paint, used to freeze the paint of a recorded draw
+    void copyState(const RiveQtPaint &other);
 
 private:
     rive::RenderPaintStyle m_paintStyle;
@@ -161,6 +154,7 @@ private:
     QBrush m_Brush;
     QPen m_Pen;
     float m_opacity { 1.0 };
+    quint64 m_strokeGeneration { 0 };
 
     rive::rcp<rive::RenderShader> m_shader;
     QSharedPointer<QGradient> m_qtGradient;
@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <algorithm>
+#include <atomic>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <QVector>
+
+#include <private/qrhi_p.h>
+
+#include "rhi/texturecache.h"
+#include "rqqplogging.h"
+
+namespace {
+// textures not drawn for this many frames are released even if the budget is not exceeded
+constexpr quint64 maximumIdleFrames = 600;
+
+std::atomic<qint64> textureBudget { 64 * 1024 * 1024 };
+
+QMutex cachesMutex;
+QHash<QQuickWindow *, TextureCache *> caches;
+}
+
+TextureCache *TextureCache::forWindow(QQuickWindow *window)
+{
+    QMutexLocker locker(&cachesMutex);
+
+    if (TextureCache *cache = caches.value(window, nullptr)) {
+        return cache;
+    }
+
+    TextureCache *cache = new TextureCache(window);
+    caches.insert(window, cache);
+    return cache;
+}
+
+void TextureCache::setBudget(qint64 bytes)
+{
+    textureBudget = bytes;
+}
+
+qint64 TextureCache::budget()
+{
+    return textureBudget;
+}
+
+TextureCache::TextureCache(QQuickWindow *window)
+    : m_window(window)
+{
+    QObject::connect(
+        window, &QQuickWindow::beforeFrameBegin, window, [this]() { beginFrame(); }, Qt::DirectConnection);
+
+    // the rhi is gone after this, so are all textures created with it
+    QObject::connect(
+        window, &QQuickWindow::sceneGraphInvalidated, window, [this]() { releaseResources(); }, Qt::DirectConnection);
+
+    QObject::connect(window, &QObject::destroyed, [window]() {
+        QMutexLocker locker(&cachesMutex);
+        delete caches.take(window);
+    });
+}
+
+TextureCache::~TextureCache()
+{
+    releaseResources();
+}
+
+QRhiTexture *TextureCache::texture(quint64 imageId, const QImage &image, QRhiResourceUpdateBatch *resourceUpdates)
+{
+    auto it = m_entries.find(imageId);
+    if (it != m_entries.end() && it->texture) {
+        // evicted pixels decode to the same size, so the texture stays valid
+        it->lastUsedFrame = m_frame;
+        m_statistics.hits++;
+        return it->texture;
+    }
+
+    QSGRendererInterface *renderInterface = m_window->rendererInterface();
+    QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+    if (!rhi || image.isNull()) {
+        return nullptr;
+    }
+
+    QRhiTexture *texture = rhi->newTexture(QRhiTexture::BGRA8, image.size(), 1);
+    if (!texture->create()) {
+        qCWarning(rqqpRendering) << "Creating texture of size" << image.size() << "failed.";
+        delete texture;
+        return nullptr;
+    }
+
+    resourceUpdates->uploadTexture(texture, image);
+
+    CacheEntry entry;
+    entry.texture = texture;
+    entry.bytes = qint64(image.width()) * image.height() * 4;
+    entry.lastUsedFrame = m_frame;
+    m_entries.insert(imageId, entry);
+
+    m_statistics.uploads++;
+    m_statistics.textures = m_entries.size();
+    m_statistics.residentBytes += entry.bytes;
+
+    qCDebug(rqqpRendering) << "Uploaded image" << imageId << "- textures:" << m_statistics.textures
+                           << "resident bytes:" << m_statistics.residentBytes;
+
+    const qint64 maxBytes = textureBudget;
+    if (maxBytes > 0 && m_statistics.residentBytes > maxBytes) {
+        trim(maxBytes);
+    }
+
+    return texture;
+}
+
+bool TextureCache::touch(quint64 imageId)
+{
+    auto it = m_entries.find(imageId);
+    if (it == m_entries.end() || !it->texture) {
+        return false;
+    }
+
+    it->lastUsedFrame = m_frame;
+    return true;
+}
+
+void TextureCache::beginFrame()
+{
+    m_frame++;
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (m_frame - it->lastUsedFrame > maximumIdleFrames) {
+            m_statistics.residentBytes -= it->bytes;
+            m_statistics.evictions++;
+            it->texture->destroy();
+            delete it->texture;
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_statistics.textures = m_entries.size();
+}
+
+void TextureCache::trim(qint64 maxBytes)
+{
+    QVector<quint64> candidates;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        // Textures drawn in the current frame are bound by nodes that did not render yet.
+        // Draws recorded in the last frame are only rendered at the begin of this one, so those are kept as well.
+        if (it->lastUsedFrame + 1 < m_frame) {
+            candidates.append(it.key());
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [this](quint64 a, quint64 b) { return m_entries.value(a).lastUsedFrame < m_entries.value(b).lastUsedFrame; });
+
+    for (quint64 imageId : qAsConst(candidates)) {
+        if (m_statistics.residentBytes <= maxBytes) {
+            break;
+        }
+
+        CacheEntry entry = m_entries.take(imageId);
+        m_statistics.residentBytes -= entry.bytes;
+        m_statistics.evictions++;
+        entry.texture->destroy();
+        delete entry.texture;
+    }
+
+    m_statistics.textures = m_entries.size();
+
+    qCDebug(rqqpRendering) << "Trimmed textures to" << m_statistics.residentBytes << "bytes";
+}
+
+void TextureCache::releaseResources()
+{
+    for (CacheEntry &entry : m_entries) {
+        entry.texture->destroy();
+        delete entry.texture;
+    }
+
+    m_entries.clear();
+    m_statistics.textures = 0;
+    m_statistics.residentBytes = 0;
+}
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+
+class QQuickWindow;
+class QRhiTexture;
+class QRhiResourceUpdateBatch;
+
+// GPU textures of RiveQtImages, shared by all TextureTargetNodes of a window.
+//
+// Textures are keyed by RiveQtImage::id() and uploaded once, instead of once per draw and frame.
+// The least recently used textures get released once the byte budget is exceeded,
+// textures that did not get drawn for a while are released even below the budget.
+// Must only be used from the render thread of the window.
+class TextureCache
+{
+public:
+    struct Statistics
+    {
+        int textures { 0 };
+        qint64 residentBytes { 0 };
+        quint64 hits { 0 };
+        quint64 uploads { 0 };
+        quint64 evictions { 0 };
+    };
+
+    static TextureCache *forWindow(QQuickWindow *window);
+
+    // Returns the texture for the image, creating and uploading it with resourceUpdates if it is not resident.
+    QRhiTexture *texture(quint64 imageId, const QImage &image, QRhiResourceUpdateBatch *resourceUpdates);
+    // Marks the texture of the image as used in this frame, returns false if it is not resident.
+    // A resident texture needs no pixels, texture() can be called with a null image for it.
+    bool touch(quint64 imageId);
+
+    Statistics statistics() const { return m_statistics; }
+
+    // Upper limit for texture memory per window in bytes, 0 means no limit.
+    static void setBudget(qint64 bytes);
+    static qint64 budget();
+
+private:
+    struct CacheEntry
+    {
+        QRhiTexture *texture { nullptr };
+        qint64 bytes { 0 };
+        quint64 lastUsedFrame { 0 };
+    };
+
+    explicit TextureCache(QQuickWindow *window);
+    ~TextureCache();
+
+    void beginFrame();
+    void trim(qint64 maxBytes);
+    void releaseResources();
+
+    QQuickWindow *m_window { nullptr };
+    QHash<quint64, CacheEntry> m_entries;
+    quint64 m_frame { 0 };
+
+    Statistics m_statistics;
+};
@@ -4,15 +4,50 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
 #include "texturetargetnode.h"
+#include "texturecache.h"
+#include "vertexbuffercache.h"
 
 #include <QFile>
 #include <QQuickItem>
 #include <QQuickWindow>
 #include <QSGRendererInterface>
+#include <QVector3D>
+#include <QVector4D>
 
 #include <private/qrhi_p.h>
 #include <private/qsgrendernode_p.h>
 
+namespace {
+// size of the uniform block of the path shaders
+constexpr int uniformBufferSize = 864;
+
+// stroke parts drawn from the centerline: segments, joins and caps
+constexpr int strokePartCount = 3;
+// vectors per instance of the centerline, see RiveQtPath::toStrokeCenterline
+constexpr int strokeInstanceVectors = 4;
+// triangles of the fans joins and caps are expanded to
+constexpr int strokeFanSegments = 16;
+constexpr int strokeTemplateVertexCounts[strokePartCount] = { 6, 3 * strokeFanSegments, 3 * strokeFanSegments };
+
+// corners of every stroke part, expanded around the centerline by drawRiveStrokeNode.vert
+QVector<QVector3D> strokeTemplate()
+{
+    QVector<QVector3D> corners = {
+        { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f }, { 1.f, 1.f, 0.f }, { -1.f, 1.f, 0.f }, { -1.f, 0.f, 0.f },
+    };
+
+    for (int part = 1; part < strokePartCount; ++part) {
+        for (int i = 0; i < strokeFanSegments; ++i) {
+            corners.append(QVector3D(0.f, 0.f, part));
+            corners.append(QVector3D(float(i) / strokeFanSegments, 1.f, part));
+            corners.append(QVector3D(float(i + 1) / strokeFanSegments, 1.f, part));
+        }
+    }
+
+    return corners;
+}
+}
+
 TextureTargetNode::TextureTargetNode(QQuickWindow *window, QRhiTexture *displayBuffer, const QRectF &viewPortRect,
                                      const QMatrix4x4 *combinedMatrix, const QMatrix4x4 *projectionMatrix)
     : m_combinedMatrix(combinedMatrix)
@@ -40,6 +75,22 @@ TextureTargetNode::TextureTargetNode(QQuickWindow *window, QRhiTexture *displayB
 
     m_blendShaders.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
 
+    file.close();
+    file.setFileName(":/shaders/qt6/drawRiveBatchNode.vert.qsb");
+    file.open(QFile::ReadOnly);
+    m_batchShaders.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
+
+    file.close();
+    file.setFileName(":/shaders/qt6/drawRiveBatchNode.frag.qsb");
+    file.open(QFile::ReadOnly);
+    m_batchShaders.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
+
+    file.close();
+    file.setFileName(":/shaders/qt6/drawRiveStrokeNode.vert.qsb");
+    file.open(QFile::ReadOnly);
+    m_strokeShaders.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
+    m_strokeShaders.append(m_pathShader.at(1)); // strokes are colored like any other path
+
     m_blendTexCoords.append(QVector2D(0.0f, 0.0f));
     m_blendTexCoords.append(QVector2D(0.0f, 1.0f));
     m_blendTexCoords.append(QVector2D(1.0f, 0.0f));
@@ -92,10 +143,22 @@ TextureTargetNode::~TextureTargetNode()
 
 void TextureTargetNode::recycle()
 {
-    m_geometryData.clear();
-    m_clippingData.clear();
-    m_texCoordData.clear();
-    m_indicesData.clear();
+    // resizing keeps the memory for the next frame, clearing would free it
+    m_geometryData.resize(0);
+    m_clippingData.resize(0);
+    m_texCoordData.resize(0);
+    m_indicesData.resize(0);
+    m_batchColorData.resize(0);
+    m_batchEntries.clear();
+    m_batchVertexCount = 0;
+    m_batchSignature = 0;
+    m_batch = false;
+    m_pathGeometry.clear();
+    m_cachedGeometry = false;
+    m_cachedVertexBuffer = nullptr;
+    m_cachedVertexCount = 0;
+    m_stencilFill = false;
+    m_gpuStroke = false;
     useGradient = 0;
     m_blendMode = rive::BlendMode::srcOver;
     m_opacity = 1.0f;
@@ -114,18 +177,6 @@ void TextureTargetNode::recycle()
             delete m_clippingUniformBuffer;
             m_clippingUniformBuffer = nullptr;
         }
-        if (m_displayBufferTarget) {
-            m_cleanupList.removeAll(m_displayBufferTarget);
-            m_displayBufferTarget->destroy();
-            delete m_displayBufferTarget;
-            m_displayBufferTarget = nullptr;
-        }
-        if (m_displayBufferTargetDescriptor) {
-            m_cleanupList.removeAll(m_displayBufferTargetDescriptor);
-            m_displayBufferTargetDescriptor->destroy();
-            delete m_displayBufferTargetDescriptor;
-            m_displayBufferTargetDescriptor = nullptr;
-        }
         if (m_clipPipeLine) {
             m_cleanupList.removeAll(m_clipPipeLine);
             m_clipPipeLine->destroy();
@@ -203,20 +254,11 @@ void TextureTargetNode::recycle()
         }
     }
 
-    if (m_qImageTexture) {
-        if (m_sampler) {
-            m_cleanupList.removeAll(m_sampler);
-            m_sampler->destroy();
-            delete m_sampler;
-            m_sampler = nullptr;
-        }
-
-        if (m_qImageTexture) {
-            m_cleanupList.removeAll(m_qImageTexture);
-            m_qImageTexture->destroy();
-            delete m_qImageTexture;
-            m_qImageTexture = nullptr;
-        }
+    if (m_textureImageId) {
+        // the texture stays in the cache, only the bindings referencing it go away
+        m_qImageTexture = nullptr;
+        m_textureImageId = 0;
+        m_texture = QImage();
 
         if (m_resourceBindings) {
             m_cleanupList.removeAll(m_resourceBindings);
@@ -257,6 +299,7 @@ void TextureTargetNode::releaseResources()
 
     m_blendTextureRenderTarget = nullptr;
     m_blendRenderDescriptor = nullptr;
+    m_renderPassDescriptor = nullptr;
 
     m_stencilClippingBuffer = nullptr;
     m_sampler = nullptr;
@@ -272,6 +315,19 @@ void TextureTargetNode::releaseResources()
     m_blendUniformBuffer = nullptr;
     m_blendResourceBindings = nullptr;
     m_blendSampler = nullptr;
+
+    m_batchColorBuffer = nullptr;
+    m_batchUniformBuffer = nullptr;
+    m_batchResourceBindings = nullptr;
+    m_batchPipeLine = nullptr;
+
+    m_strokeTemplateBuffer = nullptr;
+
+    m_drawPipelines.clear();
+    m_coverPipelines.clear();
+    m_stencilFillPipelines.clear();
+    m_strokePipelines.clear();
+
     m_resourceUpdates = nullptr;
     m_blendResourceUpdates = nullptr;
 }
@@ -281,7 +337,11 @@ void TextureTargetNode::updateViewport(const QRectF &bounds, QRhiTexture *displa
     m_displayBuffer = displayBuffer;
 
     releaseResources();
+    setBounds(bounds);
+}
 
+void TextureTargetNode::setBounds(const QRectF &bounds)
+{
     m_blendVertices.clear();
 
     m_blendVertices.append(QVector2D(bounds.x(), bounds.y()));
@@ -293,15 +353,28 @@ void TextureTargetNode::updateViewport(const QRectF &bounds, QRhiTexture *displa
     m_blendVerticesDirty = true;
 }
 
-void TextureTargetNode::prepareRender()
+void TextureTargetNode::prepareRender(QRhiResourceUpdateBatch *resourceUpdates, QRhiRenderPassDescriptor *renderPassDescriptor,
+                                      VertexBufferCache *vertexBufferCache)
 {
     QSGRendererInterface *renderInterface = m_window->rendererInterface();
     QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
     Q_ASSERT(rhi);
 
+    if (m_recycled) {
+        return;
+    }
+
+    m_resourceUpdates = resourceUpdates;
+    m_renderPassDescriptor = renderPassDescriptor;
+
+    if (m_textureImageId) {
+        // uploads the image in case it is not resident yet
+        m_qImageTexture = TextureCache::forWindow(m_window)->texture(m_textureImageId, m_texture, m_resourceUpdates);
+    }
+
     // This configures our main uniform Buffer
     if (!m_uniformBuffer) {
-        m_uniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 848);
+        m_uniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, uniformBufferSize);
         m_uniformBuffer->create();
         m_cleanupList.append(m_uniformBuffer);
     }
@@ -324,7 +397,7 @@ void TextureTargetNode::prepareRender()
     }
 
     if (!m_clippingUniformBuffer) {
-        m_clippingUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 848);
+        m_clippingUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, uniformBufferSize);
         m_clippingUniformBuffer->create();
         m_cleanupList.append(m_clippingUniformBuffer);
     }
@@ -337,53 +410,46 @@ void TextureTargetNode::prepareRender()
         m_cleanupList.append(m_clippingResourceBindings);
     }
 
-    // we create a stencil buffer, even if clipping is not on
-    // this my change later, but note that we would need to recreate all depending elements such as the RenderTargetDescription
-    if (!m_stencilClippingBuffer) {
-        m_stencilClippingBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, QSize(m_bounds.width(), m_bounds.height()), 1);
-        m_stencilClippingBuffer->create();
-        m_cleanupList.append(m_stencilClippingBuffer);
-    }
+    // Only shader blending needs a target of its own, the node is drawn into an internal texture which gets blended
+    // with the display buffer afterwards. Everything else is recorded into the shared pass of the renderer.
+    if (m_shaderBlending) {
+        if (!m_stencilClippingBuffer) {
+            m_stencilClippingBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, m_displayBuffer->pixelSize(), 1);
+            m_stencilClippingBuffer->create();
+            m_cleanupList.append(m_stencilClippingBuffer);
+        }
 
-    if (!m_displayBufferTarget) {
-        if (!m_shaderBlending) {
-            QRhiColorAttachment colorAttachment(m_displayBuffer);
-            QRhiTextureRenderTargetDescription desc(colorAttachment);
-            desc.setDepthStencilBuffer(m_stencilClippingBuffer);
-            m_displayBufferTarget = rhi->newTextureRenderTarget(desc, QRhiTextureRenderTarget::PreserveColorContents);
-        } else {
-            if (!m_internalDisplayBufferTexture) {
-                m_internalDisplayBufferTexture = rhi->newTexture(QRhiTexture::RGBA8, QSize(m_bounds.width(), m_bounds.height()), 1,
-                                                                 QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
-                m_internalDisplayBufferTexture->create();
-                m_cleanupList.append(m_internalDisplayBufferTexture);
-            }
+        if (!m_internalDisplayBufferTexture) {
+            m_internalDisplayBufferTexture = rhi->newTexture(QRhiTexture::RGBA8, m_displayBuffer->pixelSize(), 1,
+                                                             QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
+            m_internalDisplayBufferTexture->create();
+            m_cleanupList.append(m_internalDisplayBufferTexture);
+        }
 
+        if (!m_displayBufferTarget) {
             QRhiColorAttachment colorAttachment(m_internalDisplayBufferTexture);
             QRhiTextureRenderTargetDescription desc(colorAttachment);
             desc.setDepthStencilBuffer(m_stencilClippingBuffer);
             m_displayBufferTarget = rhi->newTextureRenderTarget(desc);
-        }
-
-        m_displayBufferTarget->create();
-        m_cleanupList.append(m_displayBufferTarget);
-    }
 
-    m_resourceUpdates = rhi->nextResourceUpdateBatch();
+            // same formats as the shared pass, so the pipelines created for the shared pass can be used here as well
+            m_displayBufferTargetDescriptor = m_displayBufferTarget->newCompatibleRenderPassDescriptor();
+            m_displayBufferTarget->setRenderPassDescriptor(m_displayBufferTargetDescriptor);
+            m_cleanupList.append(m_displayBufferTargetDescriptor);
 
-    if (!m_displayBufferTargetDescriptor) {
-        m_displayBufferTargetDescriptor = m_displayBufferTarget->newCompatibleRenderPassDescriptor();
-        m_displayBufferTarget->setRenderPassDescriptor(m_displayBufferTargetDescriptor);
-        m_cleanupList.append(m_displayBufferTargetDescriptor);
+            m_displayBufferTarget->create();
+            m_cleanupList.append(m_displayBufferTarget);
+        }
     }
 
     if (!m_clipPipeLine) {
         m_clipPipeLine = rhi->newGraphicsPipeline();
 
         m_clipPipeLine->setShaderStages(m_pathShader.cbegin(), m_pathShader.cend());
-        m_clipPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef);
-        m_clipPipeLine->setDepthTest(true);
-        m_clipPipeLine->setDepthWrite(true);
+        m_clipPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef | QRhiGraphicsPipeline::UsesScissor);
+        // the depth buffer is shared by all nodes of the pass, depth would reject the clip of the next node
+        m_clipPipeLine->setDepthTest(false);
+        m_clipPipeLine->setDepthWrite(false);
 
         QRhiGraphicsPipeline::TargetBlend disabledColorWrite;
         disabledColorWrite.colorWrite = QRhiGraphicsPipeline::ColorMask(0);
@@ -408,73 +474,58 @@ void TextureTargetNode::prepareRender()
         m_clipPipeLine->setCullMode(QRhiGraphicsPipeline::None);
         m_clipPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
         m_clipPipeLine->setVertexInputLayout(inputLayout);
-        m_clipPipeLine->setRenderPassDescriptor(m_displayBufferTargetDescriptor);
+        m_clipPipeLine->setRenderPassDescriptor(m_renderPassDescriptor);
 
         m_clipPipeLine->setShaderResourceBindings(m_clippingResourceBindings);
         m_clipPipeLine->create();
         m_cleanupList.append(m_clipPipeLine);
     }
 
-    if (m_drawPipelines.empty()) {
-        QList<rive::BlendMode> modes;
-        modes << rive::BlendMode::luminosity; // default shader based no blending
-        modes << rive::BlendMode::srcOver;
+    QList<rive::BlendMode> modes;
+    modes << rive::BlendMode::luminosity; // default shader based no blending
+    modes << rive::BlendMode::srcOver;
 
+    if (m_drawPipelines.empty()) {
         for (auto mode : modes) {
-            QRhiGraphicsPipeline *drawPipeLine = rhi->newGraphicsPipeline();
+            m_drawPipelines.insert(mode, createDrawPipeline(rhi, mode, false, false));
+        }
+    }
 
-            //
-            // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
-            // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
-            // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
-            // order to work around this.
-            //
-            drawPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
-            drawPipeLine->setCullMode(QRhiGraphicsPipeline::None);
-            drawPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
-
-            if (mode == rive::BlendMode::srcOver) {
-                QRhiGraphicsPipeline::TargetBlend blend;
-                blend.enable = true;
-                blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
-                blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
-                blend.srcAlpha = QRhiGraphicsPipeline::One;
-                blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
-                drawPipeLine->setTargetBlends({ blend });
+    if (m_stencilFill) {
+        if (m_coverPipelines.empty()) {
+            for (auto mode : modes) {
+                m_coverPipelines.insert(mode, createDrawPipeline(rhi, mode, true, false));
             }
+        }
 
-            drawPipeLine->setShaderResourceBindings(m_resourceBindings);
-            drawPipeLine->setShaderStages(m_pathShader.cbegin(), m_pathShader.cend());
+        if (!m_stencilFillPipelines.contains(m_stencilFillRule)) {
+            m_stencilFillPipelines.insert(m_stencilFillRule, createStencilFillPipeline(rhi, m_stencilFillRule));
+        }
+    }
 
-            QRhiVertexInputLayout inputLayout;
-            inputLayout.setBindings({
-                { sizeof(QVector2D) },
-                { sizeof(QVector2D) },
-            });
-            inputLayout.setAttributes({
-                { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
-                { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
-            });
+    if (m_gpuStroke) {
+        if (m_strokePipelines.empty()) {
+            for (auto mode : modes) {
+                m_strokePipelines.insert(mode, createDrawPipeline(rhi, mode, false, true));
+            }
+        }
 
-            drawPipeLine->setVertexInputLayout(inputLayout);
-            drawPipeLine->setRenderPassDescriptor(m_displayBufferTargetDescriptor);
-
-            QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
-                                                                    QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Equal };
-            drawPipeLine->setDepthTest(false);
-            drawPipeLine->setDepthWrite(false);
-            drawPipeLine->setStencilFront(stencilOpState);
-            drawPipeLine->setStencilBack(stencilOpState);
-            drawPipeLine->setStencilTest(true);
-            drawPipeLine->setStencilWriteMask(0);
-            drawPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef);
-
-            drawPipeLine->create();
-            m_cleanupList.append(drawPipeLine);
-            m_drawPipelines.insert(mode, drawPipeLine);
+        if (!m_strokeTemplateBuffer) {
+            const QVector<QVector3D> corners = strokeTemplate();
+            m_strokeTemplateBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, corners.size() * sizeof(QVector3D));
+            m_strokeTemplateBuffer->create();
+            m_cleanupList.append(m_strokeTemplateBuffer);
+            m_resourceUpdates->uploadStaticBuffer(m_strokeTemplateBuffer, corners.constData());
         }
     }
 
+    if (m_batch) {
+        prepareBatchRender(rhi);
+    } else if (m_cachedGeometry) {
+        // only uploads in case the path changed since it got drawn the last time
+        m_cachedVertexBuffer = vertexBufferCache->vertexBuffer(m_geometryKey, m_geometryGeneration, m_pathGeometry.vertices, m_resourceUpdates);
+    }
+
     if (m_oldBufferSize > m_geometryData.size()) {
         m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0,
                                                qMin((unsigned long long)m_clearData.size(), m_maximumVerticies * sizeof(QVector2D)),
@@ -482,19 +533,19 @@ void TextureTargetNode::prepareRender()
         m_resourceUpdates->updateDynamicBuffer(m_clippingVertexBuffer, 0,
                                                qMin((unsigned long long)m_clearData.size(), m_maximumClippingVerticies * sizeof(QVector2D)),
                                                m_clearData.constData());
+        m_uploadedBatchSignature = 0;
     } else {
-        m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0,
-                                               qMin((unsigned long long)m_geometryData.size(), m_maximumVerticies * sizeof(QVector2D)),
-                                               m_geometryData.constData());
+        if (!m_batch && !m_cachedGeometry) {
+            m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0,
+                                                   qMin((unsigned long long)m_geometryData.size(), m_maximumVerticies * sizeof(QVector2D)),
+                                                   m_geometryData.constData());
+            m_uploadedBatchSignature = 0;
+        }
         m_resourceUpdates->updateDynamicBuffer(
             m_clippingVertexBuffer, 0, qMin((unsigned long long)m_clippingData.size(), m_maximumClippingVerticies * sizeof(QVector2D)),
             m_clippingData.constData());
     }
 
-    if (m_qImageTexture) {
-        m_resourceUpdates->uploadTexture(m_qImageTexture, m_texture);
-    }
-
     if (m_texCoordBuffer) {
         m_resourceUpdates->uploadStaticBuffer(m_texCoordBuffer, m_texCoordData);
     }
@@ -518,6 +569,12 @@ void TextureTargetNode::prepareRender()
     m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 64, 4, &opacity);
     m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 76, 4, &useTexture);
 
+    if (m_gpuStroke) {
+        m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 848, 4, &m_strokeHalfWidth);
+        m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 852, 4, &m_strokeJoin);
+        m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 856, 4, &m_strokeCap);
+    }
+
     int useGradient = m_gradient != nullptr ? 1 : 0; // 72
     m_resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 72, 4, &useGradient);
 
@@ -572,22 +629,56 @@ void TextureTargetNode::render(QRhiCommandBuffer *commandBuffer)
     Q_ASSERT(commandBuffer);
 
     if (m_recycled) {
-        //    commandBuffer->beginPass(m_displayBufferTarget, QColor(0, 0, 0, 0), { 1.0f, 0 });
-        //    commandBuffer->endPass();
         return;
     }
 
-    prepareRender();
+    const QRhiViewport viewport(m_targetViewport.x(), m_targetViewport.y(), m_targetViewport.width(), m_targetViewport.height());
+
+    if (m_batch) {
+        // all batched draws are unclipped srcOver draws, a single draw call is enough
+        commandBuffer->setGraphicsPipeline(m_batchPipeLine);
+        commandBuffer->setViewport(viewport);
+        setScissor(commandBuffer);
+        commandBuffer->setShaderResources(m_batchResourceBindings);
+        QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 }, { m_batchColorBuffer, 0 } };
+        commandBuffer->setVertexInput(0, 2, vertexBindings);
+        commandBuffer->draw(m_batchVertexCount);
+        return;
+    }
+
+    if (m_cachedGeometry && !m_cachedVertexBuffer) {
+        return; // empty geometry
+    }
 
-    commandBuffer->beginPass(m_displayBufferTarget, QColor(0, 0, 0, 0), { 1.0f, 0 }, m_resourceUpdates);
+    if (m_stencilFill && m_cachedGeometry && m_pathGeometry.subPathCount() == 2) {
+        const int coverVertexCount = m_pathGeometry.subPathSize(1);
+        const int fanVertexCount = m_cachedVertexCount - coverVertexCount;
 
-    const QSize &renderTargetSize = m_displayBufferTarget->pixelSize();
+        QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_cachedVertexBuffer, 0 } };
+
+        // Step 1: sum up the windings of the fan in the stencil buffer, nothing is drawn
+        commandBuffer->setGraphicsPipeline(m_stencilFillPipelines.value(m_stencilFillRule));
+        commandBuffer->setViewport(viewport);
+        setScissor(commandBuffer);
+        commandBuffer->setShaderResources(m_resourceBindings);
+        commandBuffer->setVertexInput(0, 1, vertexBindings);
+        commandBuffer->draw(fanVertexCount);
+
+        // Step 2: cover the bounds, only where the stencil is not 0, this resets the stencil for the next nodes
+        commandBuffer->setGraphicsPipeline(m_coverPipelines.value(m_blendMode, m_coverPipelines.value(rive::BlendMode::luminosity)));
+        commandBuffer->setShaderResources(m_resourceBindings);
+        commandBuffer->setVertexInput(0, 1, vertexBindings);
+        commandBuffer->setStencilRef(0);
+        commandBuffer->draw(coverVertexCount, 1, fanVertexCount, 0);
+        return;
+    }
 
     if (m_clip) {
-        // Pass 1
+        // Step 1: mark the clipping area in the stencil buffer
         commandBuffer->setGraphicsPipeline(m_clipPipeLine);
         commandBuffer->setStencilRef(1);
-        commandBuffer->setViewport(QRhiViewport(0, 0, renderTargetSize.width(), renderTargetSize.height()));
+        commandBuffer->setViewport(viewport);
+        setScissor(commandBuffer);
         commandBuffer->setShaderResources(m_clippingResourceBindings);
         QRhiCommandBuffer::VertexInput clipVertexBindings[] = { { m_clippingVertexBuffer, 0 } };
         commandBuffer->setVertexInput(0, 1, clipVertexBindings);
@@ -595,15 +686,25 @@ void TextureTargetNode::render(QRhiCommandBuffer *commandBuffer)
         commandBuffer->setStencilRef(0);
     }
 
-    // Pass 2
+    // Step 2: draw, limited to the marked area in case of clipping
     // todo: do not use luminosity mode as "default for shader"
-    commandBuffer->setGraphicsPipeline(m_drawPipelines.value(m_blendMode, m_drawPipelines.value(rive::BlendMode::luminosity)));
-    commandBuffer->setViewport(QRhiViewport(0, 0, renderTargetSize.width(), renderTargetSize.height()));
+    if (m_gpuStroke) {
+        commandBuffer->setGraphicsPipeline(m_strokePipelines.value(m_blendMode, m_strokePipelines.value(rive::BlendMode::luminosity)));
+    } else {
+        commandBuffer->setGraphicsPipeline(m_drawPipelines.value(m_blendMode, m_drawPipelines.value(rive::BlendMode::luminosity)));
+    }
+    commandBuffer->setViewport(viewport);
+    setScissor(commandBuffer);
     commandBuffer->setShaderResources(m_resourceBindings);
 
-    if (m_qImageTexture && m_indicesBuffer && m_texCoordBuffer) {
+    if (m_gpuStroke) {
+        // the template and the instances are bound for every part in renderStroke
+    } else if (m_qImageTexture && m_indicesBuffer && m_texCoordBuffer) {
         QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 }, { m_texCoordBuffer, 0 } };
         commandBuffer->setVertexInput(0, 2, vertexBindings, m_indicesBuffer, 0, QRhiCommandBuffer::IndexUInt16);
+    } else if (m_cachedGeometry) {
+        QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_cachedVertexBuffer, 0 } };
+        commandBuffer->setVertexInput(0, 1, vertexBindings);
     } else {
         QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 } };
         commandBuffer->setVertexInput(0, 1, vertexBindings);
@@ -615,12 +716,65 @@ void TextureTargetNode::render(QRhiCommandBuffer *commandBuffer)
         commandBuffer->setStencilRef(0);
     }
 
-    if (m_qImageTexture && m_indicesBuffer) {
+    if (m_gpuStroke) {
+        renderStroke(commandBuffer);
+    } else if (m_qImageTexture && m_indicesBuffer) {
         commandBuffer->drawIndexed(m_indicesBuffer->size() / sizeof(uint16_t));
+    } else if (m_cachedGeometry) {
+        commandBuffer->draw(m_cachedVertexCount);
     } else {
         commandBuffer->draw(m_geometryData.size() / sizeof(QVector2D));
     }
 
+    if (m_clip) {
+        // Step 3: the stencil buffer is shared with the following nodes of the pass, unmark the area again
+        commandBuffer->setGraphicsPipeline(m_clipPipeLine);
+        commandBuffer->setShaderResources(m_clippingResourceBindings);
+        QRhiCommandBuffer::VertexInput clipVertexBindings[] = { { m_clippingVertexBuffer, 0 } };
+        commandBuffer->setVertexInput(0, 1, clipVertexBindings);
+        commandBuffer->setStencilRef(0);
+        commandBuffer->draw(m_clippingData.size() / sizeof(QVector2D));
+    }
+}
+
+void TextureTargetNode::setScissor(QRhiCommandBuffer *commandBuffer) const
+{
+    commandBuffer->setScissor(QRhiScissor(m_targetScissor.x(), m_targetScissor.y(), m_targetScissor.width(), m_targetScissor.height()));
+}
+
+void TextureTargetNode::renderStroke(QRhiCommandBuffer *commandBuffer)
+{
+    // every part is an instanced draw of its template, one instance per segment, join or cap
+    quint32 templateOffset = 0;
+    for (int part = 0; part < strokePartCount; ++part) {
+        const int vertexCount = strokeTemplateVertexCounts[part];
+        const int instanceCount = m_pathGeometry.subPathSize(part) / strokeInstanceVectors;
+        const bool flatCaps = part == strokePartCount - 1 && m_strokeCap == 0;
+
+        if (instanceCount > 0 && !flatCaps) {
+            QRhiCommandBuffer::VertexInput vertexBindings[] = {
+                { m_strokeTemplateBuffer, templateOffset },
+                { m_cachedVertexBuffer, quint32(m_pathGeometry.subPaths.at(part) * sizeof(QVector2D)) },
+            };
+            commandBuffer->setVertexInput(0, 2, vertexBindings);
+            commandBuffer->draw(vertexCount, instanceCount);
+        }
+
+        templateOffset += vertexCount * sizeof(QVector3D);
+    }
+}
+
+void TextureTargetNode::renderShaderBlend(QRhiCommandBuffer *commandBuffer)
+{
+    Q_ASSERT(commandBuffer);
+
+    if (m_recycled || !m_shaderBlending) {
+        return;
+    }
+
+    // draw into the internal texture first, then blend it with the display buffer
+    commandBuffer->beginPass(m_displayBufferTarget, QColor(0, 0, 0, 0), { 1.0f, 0 });
+    render(commandBuffer);
     commandBuffer->endPass();
 
     renderBlend(commandBuffer);
@@ -648,7 +802,7 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
         }
 
         if (!m_blendSrc) {
-            m_blendSrc = rhi->newTexture(QRhiTexture::RGBA8, QSize(m_bounds.width(), m_bounds.height()), 1,
+            m_blendSrc = rhi->newTexture(QRhiTexture::RGBA8, m_displayBuffer->pixelSize(), 1,
                                          QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
             m_blendSrc->create();
             m_cleanupList.append(m_blendSrc);
@@ -656,7 +810,7 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
         m_blendResourceUpdates->copyTexture(m_blendSrc, m_displayBuffer);
 
         if (!m_blendDest) {
-            m_blendDest = rhi->newTexture(QRhiTexture::RGBA8, QSize(m_bounds.width(), m_bounds.height()), 1,
+            m_blendDest = rhi->newTexture(QRhiTexture::RGBA8, m_displayBuffer->pixelSize(), 1,
                                           QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
             m_blendDest->create();
             m_cleanupList.append(m_blendDest);
@@ -839,33 +993,18 @@ void TextureTargetNode::setGradient(const QGradient *gradient)
     }
 }
 
-void TextureTargetNode::setTexture(const QImage &image, RiveQtBufferF32 *qtVertices, RiveQtBufferF32 *qtUvCoords, RiveQtBufferU16 *indices,
-                                   const QMatrix4x4 &transform)
+void TextureTargetNode::setTexture(quint64 imageId, const QImage &image, const QSize &imageSize, RiveQtBufferF32 *qtVertices,
+                                   RiveQtBufferF32 *qtUvCoords, RiveQtBufferU16 *indices, const QMatrix4x4 &transform)
 {
-    if (m_texture.size() != image.size()) {
-        if (m_sampler) {
-            m_cleanupList.removeAll(m_sampler);
-            m_sampler->destroy();
-            delete m_sampler;
-            m_sampler = nullptr;
-        }
-
-        if (m_qImageTexture) {
-            m_cleanupList.removeAll(m_qImageTexture);
-            m_qImageTexture->destroy();
-            delete m_qImageTexture;
-            m_qImageTexture = nullptr;
-        }
-
-        if (m_resourceBindings) {
-            m_cleanupList.removeAll(m_resourceBindings);
-            m_resourceBindings->destroy();
-            delete m_resourceBindings;
-            m_resourceBindings = nullptr;
-        }
+    if (m_textureImageId != imageId && m_resourceBindings) {
+        m_cleanupList.removeAll(m_resourceBindings);
+        m_resourceBindings->destroy();
+        delete m_resourceBindings;
+        m_resourceBindings = nullptr;
     }
 
     m_texture = image;
+    m_textureImageId = imageId;
     m_transform = transform;
 
     QSGRendererInterface *renderInterface = m_window->rendererInterface();
@@ -879,12 +1018,6 @@ void TextureTargetNode::setTexture(const QImage &image, RiveQtBufferF32 *qtVerti
         m_sampler->create();
     }
 
-    if (!m_qImageTexture) {
-        m_qImageTexture = rhi->newTexture(QRhiTexture::BGRA8, image.size(), 1);
-        m_cleanupList.append(m_qImageTexture);
-        m_qImageTexture->create();
-    }
-
     if (m_texCoordBuffer) {
         m_cleanupList.removeAll(m_texCoordBuffer);
         m_texCoordBuffer->destroy();
@@ -903,9 +1036,9 @@ void TextureTargetNode::setTexture(const QImage &image, RiveQtBufferF32 *qtVerti
 
         QVector<QVector2D> quadVertices = {
             QVector2D(0.0f, 0.0f), // Bottom-left
-            QVector2D(0.0f, image.height()), // Bottom-right
-            QVector2D(image.width(), 0.0f), // Top-right
-            QVector2D(image.width(), image.height()) // Top-left
+            QVector2D(0.0f, imageSize.height()), // Bottom-right
+            QVector2D(imageSize.width(), 0.0f), // Top-right
+            QVector2D(imageSize.width(), imageSize.height()) // Top-left
         };
 
         QVector<QVector2D> textureCoords = {
@@ -1046,60 +1179,77 @@ void TextureTargetNode::setBlendMode(rive::BlendMode blendMode)
     }
 }
 
-void TextureTargetNode::updateGeometry(const QVector<QVector<QVector2D>> &geometry, const QMatrix4x4 &transform)
+void TextureTargetNode::updateGeometry(const QVector<QVector2D> &vertices, const QMatrix4x4 &transform)
 {
     m_transform = transform;
 
     m_oldBufferSize = m_geometryData.size();
 
-    int vertexCount = 0;
-    for (const auto &segment : qAsConst(geometry)) {
-        vertexCount += segment.count();
-    }
+    resizeVertexBuffer(vertices.size());
 
-    // Check if we need to resize the vertex buffer
-    if (vertexCount > m_maximumVerticies) {
-        auto *renderInterface = m_window->rendererInterface();
-        auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
-        m_maximumVerticies = vertexCount;
-        if (m_vertexBuffer) {
-            // Destroy old buffer and remove from cleanup list
-            m_cleanupList.removeAll(m_vertexBuffer);
-            m_vertexBuffer->destroy();
-        }
+    m_geometryData.resize(vertices.size() * sizeof(QVector2D));
+    memcpy(m_geometryData.data(), vertices.constData(), vertices.size() * sizeof(QVector2D));
+}
 
-        // Create new buffer with updated size
-        m_vertexBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D));
-        m_cleanupList.append(m_vertexBuffer);
-        m_vertexBuffer->create();
+void TextureTargetNode::updateGeometry(const VertexBufferCache::Key &key, quint64 generation, const RiveQtPathGeometry &geometry,
+                                       const QMatrix4x4 &transform)
+{
+    m_transform = transform;
+    m_oldBufferSize = 0;
+
+    // no copy here, the vertex buffer cache decides whether the geometry needs to be uploaded at all
+    m_cachedGeometry = true;
+    m_geometryKey = key;
+    m_geometryGeneration = generation;
+    m_pathGeometry = geometry;
+    m_cachedVertexCount = geometry.vertexCount();
+}
 
-        // prepare clearing data, make as much as we need to share them
-        m_clearData.resize(std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
-        memset(m_clearData.data(), 0, std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
-    }
+void TextureTargetNode::updateStrokeGeometry(const VertexBufferCache::Key &key, quint64 generation, const RiveQtPathGeometry &centerline,
+                                             const QMatrix4x4 &transform, const QPen &pen)
+{
+    updateGeometry(key, generation, centerline, transform);
+    m_gpuStroke = true;
 
-    m_geometryData.clear();
-    m_geometryData.resize(vertexCount * sizeof(QVector2D));
+    m_strokeHalfWidth = pen.widthF() / 2.0;
 
-    int offset = 0;
-    for (const auto &segment : qAsConst(geometry)) {
-        if (segment.empty()) {
-            continue;
-        }
+    switch (pen.joinStyle()) {
+    case Qt::MiterJoin:
+    case Qt::SvgMiterJoin:
+        m_strokeJoin = 0;
+        break;
+    case Qt::BevelJoin:
+        m_strokeJoin = 1;
+        break;
+    default:
+        m_strokeJoin = 2;
+        break;
+    }
 
-        memcpy(m_geometryData.data() + offset, segment.constData(), segment.count() * sizeof(QVector2D));
-        offset += (segment.count() * sizeof(QVector2D));
+    switch (pen.capStyle()) {
+    case Qt::SquareCap:
+        m_strokeCap = 1;
+        break;
+    case Qt::RoundCap:
+        m_strokeCap = 2;
+        break;
+    default:
+        m_strokeCap = 0;
+        break;
     }
 }
 
-void TextureTargetNode::updateClippingGeometry(const QVector<QVector<QVector2D>> &clippingGeometry)
+void TextureTargetNode::setStencilFill(const bool stencilFill, const Qt::FillRule fillRule)
 {
-    setClipping(!clippingGeometry.empty());
+    m_stencilFill = stencilFill;
+    m_stencilFillRule = fillRule;
+}
 
-    int vertexCount = 0;
-    for (const auto &segment : qAsConst(clippingGeometry)) {
-        vertexCount += segment.count();
-    }
+void TextureTargetNode::updateClippingGeometry(const bool clipping, const QVector<QVector2D> &clippingGeometry)
+{
+    setClipping(clipping);
+
+    const int vertexCount = clippingGeometry.size();
 
     // Check if we need to resize the vertex buffer
     if (vertexCount > m_maximumClippingVerticies) {
@@ -1123,14 +1273,295 @@ void TextureTargetNode::updateClippingGeometry(const QVector<QVector<QVector2D>>
     }
 
     m_clippingData.resize(vertexCount * sizeof(QVector2D));
+    memcpy(m_clippingData.data(), clippingGeometry.constData(), vertexCount * sizeof(QVector2D));
+}
+
+void TextureTargetNode::appendBatchGeometry(const VertexBufferCache::Key &key, quint64 generation,
+                                            const RiveQtPathGeometry &geometry, const QMatrix4x4 &transform, const QColor &color,
+                                            const float opacity)
+{
+    if (!m_batch) {
+        m_batch = true;
+        m_oldBufferSize = 0;
+        m_transform = QMatrix4x4();
+        m_batchEntries.clear();
+        m_batchVertexCount = 0;
+        m_batchSignature = 0;
+    }
+
+    BatchEntry entry;
+    entry.vertices = geometry.vertices; // implicitly shared, transforming is deferred until we know the batch changed
+    entry.color = QVector4D(color.redF() * opacity, color.greenF() * opacity, color.blueF() * opacity, color.alphaF() * opacity);
+
+    const float *m = transform.constData();
+    entry.transform[0] = m[0];
+    entry.transform[1] = m[1];
+    entry.transform[2] = m[4];
+    entry.transform[3] = m[5];
+    entry.transform[4] = m[12];
+    entry.transform[5] = m[13];
+
+    m_batchVertexCount += geometry.vertexCount();
+
+    // everything that ends up in the vertex data, the same signature as in the last frame means nothing to upload
+    const quint64 identity[] = { key.pathId, generation, qHash(key.penWidth), key.penStyle, key.stroke };
+    m_batchSignature = qHashBits(identity, sizeof(identity), m_batchSignature);
+    m_batchSignature = qHashBits(entry.transform, sizeof(entry.transform), m_batchSignature);
+    m_batchSignature = qHashBits(&entry.color, sizeof(QVector4D), m_batchSignature);
+
+    m_batchEntries.append(entry);
+}
+
+void TextureTargetNode::prepareBatchRender(QRhi *rhi)
+{
+    resizeVertexBuffer(m_batchVertexCount);
+
+    const int batchColorBufferSize = m_maximumVerticies * sizeof(QVector4D);
+
+    if (m_batchColorBuffer && m_batchColorBuffer->size() < batchColorBufferSize) {
+        m_cleanupList.removeAll(m_batchColorBuffer);
+        m_batchColorBuffer->destroy();
+        delete m_batchColorBuffer;
+        m_batchColorBuffer = nullptr;
+    }
+
+    if (!m_batchColorBuffer) {
+        m_batchColorBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, batchColorBufferSize);
+        m_batchColorBuffer->create();
+        m_cleanupList.append(m_batchColorBuffer);
+        m_uploadedBatchSignature = 0;
+    }
+
+    if (!m_batchUniformBuffer) {
+        m_batchUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64);
+        m_batchUniformBuffer->create();
+        m_cleanupList.append(m_batchUniformBuffer);
+    }
+
+    if (!m_batchResourceBindings) {
+        m_batchResourceBindings = rhi->newShaderResourceBindings();
+        m_batchResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+            0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_batchUniformBuffer) });
+        m_batchResourceBindings->create();
+        m_cleanupList.append(m_batchResourceBindings);
+    }
+
+    if (!m_batchPipeLine) {
+        m_batchPipeLine = rhi->newGraphicsPipeline();
 
-    int offset = 0;
-    for (const auto &segment : qAsConst(clippingGeometry)) {
-        if (segment.empty()) {
-            continue;
+        m_batchPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+        m_batchPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+        m_batchPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
+        m_batchPipeLine->setFlags(QRhiGraphicsPipeline::UsesScissor);
+
+        QRhiGraphicsPipeline::TargetBlend blend;
+        blend.enable = true;
+        blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
+        blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        blend.srcAlpha = QRhiGraphicsPipeline::One;
+        blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        m_batchPipeLine->setTargetBlends({ blend });
+
+        m_batchPipeLine->setShaderResourceBindings(m_batchResourceBindings);
+        m_batchPipeLine->setShaderStages(m_batchShaders.cbegin(), m_batchShaders.cend());
+
+        QRhiVertexInputLayout inputLayout;
+        inputLayout.setBindings({
+            { sizeof(QVector2D) },
+            { sizeof(QVector4D) },
+        });
+        inputLayout.setAttributes({
+            { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position
+            { 1, 1, QRhiVertexInputAttribute::Float4, 0 } // Color
+        });
+
+        m_batchPipeLine->setVertexInputLayout(inputLayout);
+        m_batchPipeLine->setRenderPassDescriptor(m_renderPassDescriptor);
+        m_batchPipeLine->setDepthTest(false);
+        m_batchPipeLine->setDepthWrite(false);
+        m_batchPipeLine->setStencilTest(false);
+
+        m_batchPipeLine->create();
+        m_cleanupList.append(m_batchPipeLine);
+    }
+
+    m_resourceUpdates->updateDynamicBuffer(m_batchUniformBuffer, 0, 64, (*m_combinedMatrix).constData());
+
+    if (m_batchSignature == m_uploadedBatchSignature) {
+        return;
+    }
+
+    m_geometryData.resize(m_batchVertexCount * sizeof(QVector2D));
+    m_batchColorData.resize(m_batchVertexCount * sizeof(QVector4D));
+
+    QVector2D *vertices = reinterpret_cast<QVector2D *>(m_geometryData.data());
+    QVector4D *colors = reinterpret_cast<QVector4D *>(m_batchColorData.data());
+
+    // the batch shares one uniform buffer, so the transform is applied here, it is a 2D affine transform anyways
+    for (const BatchEntry &entry : qAsConst(m_batchEntries)) {
+        const float *m = entry.transform;
+        for (const QVector2D &point : entry.vertices) {
+            *vertices++ = QVector2D(m[0] * point.x() + m[2] * point.y() + m[4], m[1] * point.x() + m[3] * point.y() + m[5]);
+            *colors++ = entry.color;
         }
+    }
+
+    m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0, m_geometryData.size(), m_geometryData.constData());
+    m_resourceUpdates->updateDynamicBuffer(m_batchColorBuffer, 0, m_batchColorData.size(), m_batchColorData.constData());
 
-        memcpy(m_clippingData.data() + offset, segment.constData(), segment.count() * sizeof(QVector2D));
-        offset += (segment.count() * sizeof(QVector2D));
+    m_uploadedBatchSignature = m_batchSignature;
+}
+
+QRhiGraphicsPipeline *TextureTargetNode::createDrawPipeline(QRhi *rhi, rive::BlendMode mode, bool cover, bool stroke)
+{
+    QRhiGraphicsPipeline *drawPipeLine = rhi->newGraphicsPipeline();
+
+    //
+    // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
+    // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
+    // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
+    // order to work around this.
+    //
+    drawPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+    drawPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    drawPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
+
+    if (mode == rive::BlendMode::srcOver) {
+        QRhiGraphicsPipeline::TargetBlend blend;
+        blend.enable = true;
+        blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
+        blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        blend.srcAlpha = QRhiGraphicsPipeline::One;
+        blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        drawPipeLine->setTargetBlends({ blend });
     }
+
+    drawPipeLine->setShaderResourceBindings(m_resourceBindings);
+
+    QRhiVertexInputLayout inputLayout;
+    if (stroke) {
+        drawPipeLine->setShaderStages(m_strokeShaders.cbegin(), m_strokeShaders.cend());
+        inputLayout.setBindings({
+            { sizeof(QVector3D) },
+            { strokeInstanceVectors * sizeof(QVector2D), QRhiVertexInputBinding::PerInstance },
+        });
+        inputLayout.setAttributes({
+            { 0, 0, QRhiVertexInputAttribute::Float3, 0 }, // Template corner
+            { 1, 1, QRhiVertexInputAttribute::Float4, 0 }, // Start and end point
+            { 1, 2, QRhiVertexInputAttribute::Float4, 2 * sizeof(QVector2D) } // Start and end normal
+        });
+    } else {
+        drawPipeLine->setShaderStages(m_pathShader.cbegin(), m_pathShader.cend());
+        inputLayout.setBindings({
+            { sizeof(QVector2D) },
+            { sizeof(QVector2D) },
+        });
+        inputLayout.setAttributes({
+            { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
+            { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
+        });
+    }
+
+    drawPipeLine->setVertexInputLayout(inputLayout);
+    drawPipeLine->setRenderPassDescriptor(m_renderPassDescriptor);
+
+    drawPipeLine->setDepthTest(false);
+    drawPipeLine->setDepthWrite(false);
+    drawPipeLine->setStencilTest(true);
+    drawPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef | QRhiGraphicsPipeline::UsesScissor);
+
+    if (cover) {
+        // draws where the fan left a winding, and resets the stencil to the reference (0) on the way
+        QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::NotEqual };
+        drawPipeLine->setStencilFront(stencilOpState);
+        drawPipeLine->setStencilBack(stencilOpState);
+    } else {
+        QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Equal };
+        drawPipeLine->setStencilFront(stencilOpState);
+        drawPipeLine->setStencilBack(stencilOpState);
+        drawPipeLine->setStencilWriteMask(0);
+    }
+
+    drawPipeLine->create();
+    m_cleanupList.append(drawPipeLine);
+
+    return drawPipeLine;
+}
+
+QRhiGraphicsPipeline *TextureTargetNode::createStencilFillPipeline(QRhi *rhi, Qt::FillRule fillRule)
+{
+    QRhiGraphicsPipeline *stencilPipeLine = rhi->newGraphicsPipeline();
+
+    stencilPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+    stencilPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    stencilPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
+    stencilPipeLine->setShaderResourceBindings(m_resourceBindings);
+    stencilPipeLine->setShaderStages(m_pathShader.cbegin(), m_pathShader.cend());
+    stencilPipeLine->setDepthTest(false);
+    stencilPipeLine->setDepthWrite(false);
+    stencilPipeLine->setFlags(QRhiGraphicsPipeline::UsesScissor);
+
+    QRhiGraphicsPipeline::TargetBlend disabledColorWrite;
+    disabledColorWrite.colorWrite = QRhiGraphicsPipeline::ColorMask(0);
+    stencilPipeLine->setTargetBlends({ disabledColorWrite });
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) },
+        { sizeof(QVector2D) },
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+        { 1, 1, QRhiVertexInputAttribute::Float2, 0 },
+    });
+    stencilPipeLine->setVertexInputLayout(inputLayout);
+    stencilPipeLine->setRenderPassDescriptor(m_renderPassDescriptor);
+
+    // winding: front faces count up, back faces count down
+    // odd even: every triangle flips the bits, covering an even number of times leaves 0
+    QRhiGraphicsPipeline::StencilOpState frontOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                          QRhiGraphicsPipeline::IncrementAndWrap, QRhiGraphicsPipeline::Always };
+    QRhiGraphicsPipeline::StencilOpState backOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                         QRhiGraphicsPipeline::DecrementAndWrap, QRhiGraphicsPipeline::Always };
+    if (fillRule == Qt::OddEvenFill) {
+        frontOpState.passOp = QRhiGraphicsPipeline::Invert;
+        backOpState.passOp = QRhiGraphicsPipeline::Invert;
+    }
+    stencilPipeLine->setStencilFront(frontOpState);
+    stencilPipeLine->setStencilBack(backOpState);
+    stencilPipeLine->setStencilTest(true);
+
+    stencilPipeLine->create();
+    m_cleanupList.append(stencilPipeLine);
+
+    return stencilPipeLine;
+}
+
+void TextureTargetNode::resizeVertexBuffer(const int vertexCount)
+{
+    // Check if we need to resize the vertex buffer
+    if (vertexCount <= m_maximumVerticies) {
+        return;
+    }
+
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+    m_maximumVerticies = vertexCount;
+    if (m_vertexBuffer) {
+        // Destroy old buffer and remove from cleanup list
+        m_cleanupList.removeAll(m_vertexBuffer);
+        m_vertexBuffer->destroy();
+    }
+
+    // Create new buffer with updated size
+    m_vertexBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D));
+    m_cleanupList.append(m_vertexBuffer);
+    m_vertexBuffer->create();
+    m_uploadedBatchSignature = 0;
+
+    // prepare clearing data, make as much as we need to share them
+    m_clearData.resize(std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
+    memset(m_clearData.data(), 0, std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
 }
@@ -11,9 +11,13 @@
 
 #include <QPainterPath>
 #include <QSGRenderNode>
+#include <QVector4D>
 
+#include "riveqtpath.h"
 #include "riveqtutils.h"
+#include "vertexbuffercache.h"
 
+class QRhi;
 class QRhiCommandBuffer;
 class QRhiResourceUpdateBatch;
 #define INITIAL_VERTICES 1000
@@ -43,30 +47,82 @@ public:
     void recycle();
     void take() { m_recycled = false; }
 
+    // Creates the resources needed for drawing and records their updates into resourceUpdates.
+    // The pipelines are created for render passes compatible with renderPassDescriptor.
+    // Geometries of paths are taken from vertexBufferCache.
+    void prepareRender(QRhiResourceUpdateBatch *resourceUpdates, QRhiRenderPassDescriptor *renderPassDescriptor,
+                       VertexBufferCache *vertexBufferCache);
+
+    // records the drawing commands into the render pass that is currently recorded
     void render(QRhiCommandBuffer *cb);
+    // Drawing is mapped to viewport and limited to scissor, both in pixels of the display buffer with the origin at the bottom left.
+    // The display buffer can be larger than the item, the item is drawn into the viewport then.
+    void setTargetArea(const QRect &viewport, const QRect &scissor)
+    {
+        m_targetViewport = viewport;
+        m_targetScissor = scissor;
+    }
+
+    // Shader blend modes need to read the destination, those nodes cannot be drawn within a shared pass
+    // and render with passes of their own through renderShaderBlend, outside of any other pass.
+    bool needsShaderBlending() const { return m_shaderBlending; }
+    void renderShaderBlend(QRhiCommandBuffer *cb);
     void renderBlend(QRhiCommandBuffer *cb);
     void releaseResources();
     void updateViewport(const QRectF &viewPortRect, QRhiTexture *displayBuffer);
+    // the item got another size while the display buffer stays the same
+    void setBounds(const QRectF &viewPortRect);
 
     void setOpacity(const float opacity);
     void setClipping(const bool clip);
 
     void setColor(const QColor &color);
     void setGradient(const QGradient *gradient);
-    void setTexture(const QImage &image, RiveQtBufferF32 *verticies, RiveQtBufferF32 *uv, RiveQtBufferU16 *indices,
-                    const QMatrix4x4 &transform);
+    // The texture is taken from the TextureCache of the window, imageId identifies the image there.
+    // image is only needed for the upload and can be null while the texture is resident.
+    void setTexture(quint64 imageId, const QImage &image, const QSize &imageSize, RiveQtBufferF32 *verticies, RiveQtBufferF32 *uv,
+                    RiveQtBufferU16 *indices, const QMatrix4x4 &transform);
 
     int blendMode() const { return (int)m_blendMode; }
     void setBlendMode(rive::BlendMode blendMode);
 
-    void updateGeometry(const QVector<QVector<QVector2D>> &geometry, const QMatrix4x4 &transform);
-    void updateClippingGeometry(const QVector<QVector<QVector2D>> &clippingGeometry);
+    void updateGeometry(const QVector<QVector2D> &vertices, const QMatrix4x4 &transform);
+    // geometry of a path, uploaded through the VertexBufferCache only in case the generation of the path changed
+    void updateGeometry(const VertexBufferCache::Key &key, quint64 generation, const RiveQtPathGeometry &geometry,
+                        const QMatrix4x4 &transform);
+    // Centerline of a stroke, see RiveQtPath::toStrokeCenterline. It is expanded to the stroke in the vertex shader,
+    // so the geometry only depends on the path and a changing pen only changes uniforms.
+    void updateStrokeGeometry(const VertexBufferCache::Key &key, quint64 generation, const RiveQtPathGeometry &centerline,
+                              const QMatrix4x4 &transform, const QPen &pen);
+    void updateClippingGeometry(const bool clipping, const QVector<QVector2D> &clippingGeometry);
+
+    // The geometry is a triangle fan followed by a quad covering it, see RiveQtTessellator::stencilFan.
+    // The fan resolves the fill rule in the stencil buffer, the quad draws where the stencil got marked.
+    // The stencil buffer is shared with clipping, so this is only supported for unclipped paths.
+    void setStencilFill(const bool stencilFill, const Qt::FillRule fillRule);
+
+    // Appends a solid color geometry to this node, so consecutive draws end up in one draw call.
+    // Vertices are transformed on the cpu and the color is stored per vertex, this only works for unclipped srcOver draws.
+    // The batch is only transformed and uploaded again if any path, transform or color differs from the last frame.
+    void appendBatchGeometry(const VertexBufferCache::Key &key, quint64 generation, const RiveQtPathGeometry &geometry,
+                             const QMatrix4x4 &transform, const QColor &color, const float opacity);
+    bool isBatch() const { return m_batch; }
 
 private:
-    void prepareRender();
+    void prepareBatchRender(QRhi *rhi);
+    void renderStroke(QRhiCommandBuffer *cb);
+    void setScissor(QRhiCommandBuffer *cb) const;
+    QRhiGraphicsPipeline *createDrawPipeline(QRhi *rhi, rive::BlendMode mode, bool cover, bool stroke);
+    QRhiGraphicsPipeline *createStencilFillPipeline(QRhi *rhi, Qt::FillRule fillRule);
+    void resizeVertexBuffer(const int vertexCount);
 
     bool m_recycled { true };
     bool m_clip { false };
+    bool m_batch { false };
+    bool m_cachedGeometry { false };
+    bool m_stencilFill { false };
+    Qt::FillRule m_stencilFillRule { Qt::WindingFill };
+    bool m_gpuStroke { false };
 
     bool m_blendVerticesDirty = true;
     bool m_shaderBlending = false;
@@ -76,6 +132,8 @@ private:
     int m_oldBufferSize = 0;
 
     QSize m_textureSize;
+    QRect m_targetViewport;
+    QRect m_targetScissor;
 
     QVector<QRhiResource *> m_cleanupList;
 
@@ -91,20 +149,31 @@ private:
     QRhiBuffer *m_clippingVertexBuffer { nullptr };
     QRhiBuffer *m_clippingUniformBuffer { nullptr };
 
+    QRhiBuffer *m_batchColorBuffer { nullptr };
+    QRhiBuffer *m_batchUniformBuffer { nullptr };
+
+    QRhiBuffer *m_strokeTemplateBuffer { nullptr };
+
     QRhiShaderResourceBindings *m_resourceBindings { nullptr };
     QRhiShaderResourceBindings *m_clippingResourceBindings { nullptr };
     QRhiShaderResourceBindings *m_blendResourceBindings { nullptr };
+    QRhiShaderResourceBindings *m_batchResourceBindings { nullptr };
 
     QMap<rive::BlendMode, QRhiGraphicsPipeline *> m_drawPipelines;
+    QMap<rive::BlendMode, QRhiGraphicsPipeline *> m_coverPipelines;
+    QMap<Qt::FillRule, QRhiGraphicsPipeline *> m_stencilFillPipelines;
+    QMap<rive::BlendMode, QRhiGraphicsPipeline *> m_strokePipelines;
 
     QRhiGraphicsPipeline *m_blendPipeLine { nullptr };
     QRhiGraphicsPipeline *m_clipPipeLine { nullptr };
+    QRhiGraphicsPipeline *m_batchPipeLine { nullptr };
 
     QRhiTextureRenderTarget *m_displayBufferTarget { nullptr };
     QRhiTextureRenderTarget *m_blendTextureRenderTarget { nullptr };
 
     QRhiRenderPassDescriptor *m_displayBufferTargetDescriptor { nullptr };
     QRhiRenderPassDescriptor *m_blendRenderDescriptor { nullptr };
+    QRhiRenderPassDescriptor *m_renderPassDescriptor { nullptr }; // owned by the renderer
 
     QRhiRenderBuffer *m_stencilClippingBuffer { nullptr };
 
@@ -114,10 +183,12 @@ private:
     QList<QRhiShaderStage> m_pathShader;
     QList<QRhiShaderStage> m_textureShader;
     QList<QRhiShaderStage> m_blendShaders;
+    QList<QRhiShaderStage> m_batchShaders;
+    QList<QRhiShaderStage> m_strokeShaders;
 
     QRhiTexture *m_displayBuffer { nullptr };
     QRhiTexture *m_internalDisplayBufferTexture { nullptr };
-    QRhiTexture *m_qImageTexture { nullptr };
+    QRhiTexture *m_qImageTexture { nullptr }; // owned by the TextureCache
     QRhiTexture *m_blendSrc { nullptr };
     QRhiTexture *m_blendDest { nullptr };
 
@@ -130,9 +201,14 @@ private:
     QColor m_color;
     const QGradient *m_gradient { nullptr };
     QImage m_texture;
+    quint64 m_textureImageId { 0 };
 
     float m_opacity { 1.0 };
 
+    float m_strokeHalfWidth { 0.f }; // 848
+    int m_strokeJoin { 0 }; // 852, 0 -> miter, 1 -> bevel, 2 -> round
+    int m_strokeCap { 0 }; // 856, 0 -> flat, 1 -> square, 2 -> round
+
     rive::BlendMode m_blendMode = rive::BlendMode::srcOver;
 
     int useGradient; // 0 -> false , 1 -> true
@@ -151,6 +227,25 @@ private:
     QByteArray m_clippingData;
     QByteArray m_texCoordData;
     QByteArray m_indicesData;
+    QByteArray m_batchColorData; // color multiplied with the opacity, one QVector4D per vertex in m_geometryData
+
+    struct BatchEntry
+    {
+        QVector<QVector2D> vertices; // shared with the path until the node gets recycled
+        float transform[6]; // 2D affine transform, column major without the unused components
+        QVector4D color;
+    };
+
+    QVector<BatchEntry> m_batchEntries;
+    int m_batchVertexCount { 0 };
+    size_t m_batchSignature { 0 };
+    size_t m_uploadedBatchSignature { 0 }; // signature of the data in m_vertexBuffer and m_batchColorBuffer
+
+    VertexBufferCache::Key m_geometryKey;
+    quint64 m_geometryGeneration { 0 };
+    RiveQtPathGeometry m_pathGeometry;
+    QRhiBuffer *m_cachedVertexBuffer { nullptr }; // owned by the VertexBufferCache
+    int m_cachedVertexCount { 0 };
     QByteArray m_clearData; // this is as large as it must and used in case we reduce the size of a geometry but not reducing the buffer
 
     struct GradientData
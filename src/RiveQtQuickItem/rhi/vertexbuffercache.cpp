@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <private/qrhi_p.h>
+
+#include "rhi/vertexbuffercache.h"
+#include "rqqplogging.h"
+
+namespace {
+// paths not drawn for this many frames are considered gone, their buffers are released
+constexpr quint64 maximumIdleFrames = 120;
+}
+
+VertexBufferCache::VertexBufferCache(QRhi *rhi)
+    : m_rhi(rhi)
+{
+}
+
+VertexBufferCache::~VertexBufferCache()
+{
+    releaseResources();
+}
+
+QRhiBuffer *VertexBufferCache::vertexBuffer(const Key &key, quint64 generation, const QVector<QVector2D> &vertices,
+                                            QRhiResourceUpdateBatch *resourceUpdates)
+{
+    CacheEntry &entry = m_entries[key];
+    entry.lastUsedFrame = m_frame;
+
+    if (entry.buffer && entry.generation == generation) {
+        m_statistics.hits++;
+        return entry.buffer;
+    }
+
+    const quint32 size = vertices.size() * sizeof(QVector2D);
+
+    if (size == 0) {
+        return nullptr;
+    }
+
+    // an animated path keeps its buffer as long as the geometry fits into it
+    if (entry.buffer && entry.buffer->size() < size) {
+        m_statistics.residentBytes -= entry.buffer->size();
+        entry.buffer->destroy();
+        delete entry.buffer;
+        entry.buffer = nullptr;
+    }
+
+    if (!entry.buffer) {
+        entry.buffer = m_rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, size);
+        if (!entry.buffer->create()) {
+            qCWarning(rqqpRendering) << "Creating vertex buffer of size" << size << "failed.";
+            delete entry.buffer;
+            m_entries.remove(key);
+            return nullptr;
+        }
+        m_statistics.residentBytes += size;
+    }
+
+    // the vertices of a path are contiguous already, no need to gather them first
+    resourceUpdates->uploadStaticBuffer(entry.buffer, 0, size, vertices.constData());
+    entry.generation = generation;
+
+    m_statistics.uploads++;
+    m_statistics.buffers = m_entries.size();
+
+    return entry.buffer;
+}
+
+void VertexBufferCache::beginFrame()
+{
+    m_frame++;
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (m_frame - it->lastUsedFrame > maximumIdleFrames) {
+            if (it->buffer) {
+                m_statistics.residentBytes -= it->buffer->size();
+                it->buffer->destroy();
+                delete it->buffer;
+            }
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_statistics.buffers = m_entries.size();
+
+    qCDebug(rqqpRendering) << "Vertex buffers:" << m_statistics.buffers << "resident bytes:" << m_statistics.residentBytes
+                           << "hits:" << m_statistics.hits << "uploads:" << m_statistics.uploads;
+}
+
+void VertexBufferCache::releaseResources()
+{
+    for (CacheEntry &entry : m_entries) {
+        if (entry.buffer) {
+            entry.buffer->destroy();
+            delete entry.buffer;
+        }
+    }
+
+    m_entries.clear();
+    m_statistics.buffers = 0;
+    m_statistics.residentBytes = 0;
+}
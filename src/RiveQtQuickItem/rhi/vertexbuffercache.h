@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include <QVector2D>
+
+class QRhi;
+class QRhiBuffer;
+class QRhiResourceUpdateBatch;
+
+// GPU vertex buffers of path geometries, kept across frames.
+//
+// Entries are identified by the RiveQtPath and the way it is drawn, since strokes with different
+// pens, other fill methods and other flattening tolerances turn the same path into different geometries.
+// A buffer is only uploaded again once the
+// generation of the path changed, static shapes are uploaded once.
+// Entries that were not used for a couple of frames get released.
+class VertexBufferCache
+{
+public:
+    struct Key
+    {
+        quint64 pathId { 0 };
+        float tolerance { 0.f }; // snapped flattening tolerance of the draw, see RiveQtPath::toleranceForDeviceScale
+        uint fillMethod { 0 }; // unused for strokes
+        bool stroke { false };
+        // pen properties changing the stroke geometry, unused for fills
+        float penWidth { 0.f };
+        uint penStyle { 0 }; // join and cap style
+    };
+
+    struct Statistics
+    {
+        int buffers { 0 };
+        qint64 residentBytes { 0 };
+        quint64 hits { 0 };
+        quint64 uploads { 0 };
+    };
+
+    explicit VertexBufferCache(QRhi *rhi);
+    ~VertexBufferCache();
+
+    // Returns the vertex buffer holding the geometry, uploading it with resourceUpdates in case
+    // there is no buffer for key yet or it was created from another generation.
+    QRhiBuffer *vertexBuffer(const Key &key, quint64 generation, const QVector<QVector2D> &vertices,
+                             QRhiResourceUpdateBatch *resourceUpdates);
+
+    // starts a new frame, entries unused for too long are released
+    void beginFrame();
+    void releaseResources();
+
+    Statistics statistics() const { return m_statistics; }
+
+private:
+    struct CacheEntry
+    {
+        QRhiBuffer *buffer { nullptr };
+        quint64 generation { 0 };
+        quint64 lastUsedFrame { 0 };
+    };
+
+    QRhi *m_rhi { nullptr };
+    QHash<Key, CacheEntry> m_entries;
+    quint64 m_frame { 0 };
+
+    Statistics m_statistics;
+};
+
+inline bool operator==(const VertexBufferCache::Key &a, const VertexBufferCache::Key &b)
+{
+    return a.pathId == b.pathId && a.tolerance == b.tolerance && a.fillMethod == b.fillMethod && a.stroke == b.stroke
+        && a.penWidth == b.penWidth && a.penStyle == b.penStyle;
+}
+
+inline size_t qHash(const VertexBufferCache::Key &key, size_t seed = 0)
+{
+    return qHash(key.pathId, seed) ^ qHash(key.tolerance, seed) ^ qHash(key.penWidth, seed) ^ (size_t(key.fillMethod) << 8)
+        ^ (size_t(key.penStyle) << 1) ^ size_t(key.stroke);
+}
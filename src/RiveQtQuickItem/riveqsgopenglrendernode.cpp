@@ -35,6 +35,7 @@ RiveQSGOpenGLRenderNode::RiveQSGOpenGLRenderNode(QQuickWindow *window, std::weak
 {
     initializeOpenGLFunctions();
     m_renderer.initGL();
+    m_displayList = std::make_unique<RiveQtDisplayList>(RiveQtFactory::RiveQtRenderType::QOpenGLRenderer);
 }
 
 void RiveQSGOpenGLRenderNode::render(const RenderState *state)
@@ -70,6 +71,7 @@ void RiveQSGOpenGLRenderNode::renderOpenGL(const RenderState *state)
     m_renderer.updateViewportSize();
     m_renderer.updateModelMatrix(modelMatrix);
     m_renderer.updateProjectionMatrix(mvp);
+    m_renderer.setFillMethod(m_fillMethod);
 
     glEnable(GL_SCISSOR_TEST);
     glScissor(scissorX, scissorY, itemWidth, itemHeight);
@@ -78,6 +80,7 @@ void RiveQSGOpenGLRenderNode::renderOpenGL(const RenderState *state)
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     // this renders the artboard!
-    m_artboardInstance.lock()->draw(&m_renderer);
+    recordDisplayList();
+    m_displayList->replay(&m_renderer);
     glDisable(GL_SCISSOR_TEST);
 }
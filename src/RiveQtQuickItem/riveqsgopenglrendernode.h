@@ -15,6 +15,7 @@
 
 #include "riveqsgrendernode.h"
 #include "renderer/riveqtopenglrenderer.h"
+#include "renderer/riveqtdisplaylist.h"
 
 class RiveQtQuickItem;
 
@@ -5,6 +5,7 @@
 
 #include "riveqsgrendernode.h"
 #include "riveqtquickitem.h"
+#include "renderer/riveqtdisplaylist.h"
 
 QRectF RiveQSGRenderNode::rect() const
 {
@@ -23,9 +24,71 @@ RiveQSGBaseNode::RiveQSGBaseNode(QQuickWindow *window, std::weak_ptr<rive::Artbo
     Q_ASSERT(m_window);
 }
 
+RiveQSGBaseNode::~RiveQSGBaseNode() = default;
+
+void RiveQSGBaseNode::updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance> artboardInstance)
+{
+    m_artboardInstance = artboardInstance;
+    // a frame handed over before might still show the previous artboard
+    m_recordsArtboard = true;
+    requireRedraw();
+}
+
+void RiveQSGBaseNode::setFillMethod(const RiveRenderSettings::FillMethod fillMethod)
+{
+    if (m_fillMethod == fillMethod) {
+        return;
+    }
+
+    m_fillMethod = fillMethod;
+    requireRedraw();
+}
+
+void RiveQSGBaseNode::setRenderScale(const qreal renderScale)
+{
+    if (m_renderScale == renderScale) {
+        return;
+    }
+
+    m_renderScale = renderScale;
+    requireRedraw();
+}
+
+void RiveQSGBaseNode::swapDisplayList(std::unique_ptr<RiveQtDisplayList> &displayList)
+{
+    if (!displayList) {
+        return;
+    }
+
+    std::swap(m_displayList, displayList);
+    m_recordsArtboard = false;
+    m_frameDue = true;
+}
+
+bool RiveQSGBaseNode::recordDisplayList()
+{
+    if (!m_frameDue) {
+        return false;
+    }
+    m_frameDue = false;
+
+    if (!m_recordsArtboard || !m_displayList) {
+        return true;
+    }
+
+    m_displayList->setDecodeListener(m_decodeListener);
+    m_displayList->beginRecording();
+    if (auto artboardInstance = m_artboardInstance.lock(); artboardInstance) {
+        artboardInstance->draw(m_displayList.get());
+    }
+    m_displayList->endRecording();
+    return true;
+}
+
 void RiveQSGBaseNode::setRect(const QRectF &bounds)
 {
     m_rect = bounds;
+    requireRedraw();
 }
 
 QPointF RiveQSGBaseNode::topLeft() const
@@ -47,6 +110,7 @@ void RiveQSGBaseNode::setArtboardRect(const QRectF &bounds)
 {
     m_topLeftRivePosition = bounds.topLeft();
     m_riveSize = bounds.size();
+    requireRedraw();
 
     if (auto artboardInstance = m_artboardInstance.lock(); artboardInstance) {
         m_scaleFactorX = bounds.width() / artboardInstance->width();
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <QElapsedTimer>
 #include <QQuickItem>
 #include <QQuickPaintedItem>
@@ -13,10 +15,16 @@
 
 #include <rive/artboard.hpp>
 
+#include "datatypes.h"
+
+class RiveQtDecodeListener;
+class RiveQtDisplayList;
+
 class RiveQSGBaseNode
 {
 public:
     RiveQSGBaseNode(QQuickWindow *window, std::weak_ptr<rive::ArtboardInstance> artboardInstance, const QRectF &geometry);
+    ~RiveQSGBaseNode();
 
     virtual void renderOffscreen() { }
     virtual void setRect(const QRectF &bounds);
@@ -24,11 +32,35 @@ public:
     virtual float scaleFactorX() const;
     virtual float scaleFactorY() const;
 
-    virtual void updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance> artboardInstance) { m_artboardInstance = artboardInstance; }
+    virtual void updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance> artboardInstance);
 
     virtual void setArtboardRect(const QRectF &bounds);
 
+    void setFillMethod(const RiveRenderSettings::FillMethod fillMethod);
+    void setRenderScale(const qreal renderScale);
+    // passed on to the display list the node records itself
+    void setDecodeListener(const std::shared_ptr<RiveQtDecodeListener> &decodeListener) { m_decodeListener = decodeListener; }
+
+    // Hands over a frame recorded outside of the render thread, it gets replayed instead of recording the artboard here.
+    // displayList receives the list replayed before, the next frame can be recorded into it.
+    void swapDisplayList(std::unique_ptr<RiveQtDisplayList> &displayList);
+    // the artboard gets recorded by the node again, right before it is rendered
+    void setRecordsArtboard(bool recordsArtboard) { m_recordsArtboard = recordsArtboard; }
+    bool recordsArtboard() const { return m_recordsArtboard; }
+    // the artboard advanced, until then the node keeps showing its last frame
+    void markFrameDue() { m_frameDue = true; }
+
 protected:
+    // Records the artboard into m_displayList, unless the frame got handed over by the item.
+    // Returns false in case no new frame is due, m_displayList still holds the last one then.
+    bool recordDisplayList();
+    // the render state changed, the last frame can not be reused even if the artboard looks the same
+    void requireRedraw()
+    {
+        m_frameDue = true;
+        m_redrawRequired = true;
+    }
+
     std::weak_ptr<rive::ArtboardInstance> m_artboardInstance;
     QRectF m_rect;
     QPointF m_topLeftRivePosition { 0.f, 0.f };
@@ -37,6 +69,15 @@ protected:
 
     float m_scaleFactorX { 1.0f };
     float m_scaleFactorY { 1.0f };
+
+    RiveRenderSettings::FillMethod m_fillMethod { RiveRenderSettings::Tessellator };
+    qreal m_renderScale { 0.0 };
+
+    std::unique_ptr<RiveQtDisplayList> m_displayList;
+    std::shared_ptr<RiveQtDecodeListener> m_decodeListener;
+    bool m_recordsArtboard { true };
+    bool m_frameDue { true };
+    bool m_redrawRequired { true };
 };
 
 class RiveQSGRenderNode : public QSGRenderNode, public RiveQSGBaseNode
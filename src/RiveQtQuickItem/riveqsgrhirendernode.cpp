@@ -3,6 +3,8 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <algorithm>
+
 #include <QQuickWindow>
 #include <QFile>
 
@@ -13,6 +15,19 @@
 #include "riveqtquickitem.h"
 #include "renderer/riveqtrhirenderer.h"
 
+namespace {
+// Display buffers are allocated in steps, an item changing its size only needs a new one once it crosses a step.
+// A display buffer larger than needed is kept for a while, an animated resize shrinking and growing again keeps it.
+constexpr int displayBufferStep = 64;
+constexpr int shrinkDelayFrames = 120;
+
+QSize displayBufferSize(const QSize &contentSize)
+{
+    const auto stepUp = [](int length) { return qMax(1, (length + displayBufferStep - 1) / displayBufferStep) * displayBufferStep; };
+    return QSize(stepUp(contentSize.width()), stepUp(contentSize.height()));
+}
+}
+
 RiveQSGRHIRenderNode::RiveQSGRHIRenderNode(QQuickWindow *window, std::weak_ptr<rive::ArtboardInstance> artboardInstance,
                                            const QRectF &geometry)
     : RiveQSGRenderNode(window, artboardInstance, geometry)
@@ -38,6 +53,7 @@ RiveQSGRHIRenderNode::RiveQSGRHIRenderNode(QQuickWindow *window, std::weak_ptr<r
 
     m_renderer = new RiveQtRhiRenderer(window);
     m_renderer->updateViewPort(m_rect, m_displayBuffer);
+    m_displayList = std::make_unique<RiveQtDisplayList>(RiveQtFactory::RiveQtRenderType::RHIRenderer);
     m_renderer->setRiveRect({ m_topLeftRivePosition, m_riveSize });
 }
 
@@ -57,39 +73,9 @@ void RiveQSGRHIRenderNode::setRect(const QRectF &bounds)
     m_vertices.append(QVector2D(bounds.x() + bounds.width(), bounds.y()));
     m_vertices.append(QVector2D(bounds.x() + bounds.width(), bounds.y() + bounds.height()));
 
-    // todo this is not yet fully correct. Resize is super expensive due to resource destruction
-    // TODO: maybe we should only do this in case the texture gets larger and stays larger for some time
-    // that may cost us quality but will save us a lot of issues
-    if (m_displayBuffer) {
-        m_cleanupList.removeAll(m_displayBuffer);
-        m_displayBuffer->destroy();
-        m_displayBuffer->deleteLater();
-        m_displayBuffer = nullptr;
-    }
-
-    if (m_sampler) {
-        m_cleanupList.removeAll(m_sampler);
-        m_sampler->destroy();
-        m_sampler->deleteLater();
-        m_sampler = nullptr;
-    }
-
-    if (m_cleanUpTextureTarget) {
-        m_cleanupList.removeAll(m_cleanUpTextureTarget);
-        m_cleanUpTextureTarget->destroy();
-        m_cleanUpTextureTarget->deleteLater();
-        m_cleanUpTextureTarget = nullptr;
-    }
-
-    // this potentialy crashes :/
-    if (m_resourceBindings) {
-        m_cleanupList.removeAll(m_resourceBindings);
-        m_resourceBindings->destroy();
-        m_resourceBindings->deleteLater();
-        m_resourceBindings = nullptr;
-    }
-
+    // the display buffer is only replaced in prepare, once the item does not fit anymore or stayed smaller for a while
     m_verticesDirty = true;
+    m_viewportDirty = true;
 
     RiveQSGBaseNode::setRect(bounds);
     markDirty(QSGNode::DirtyGeometry);
@@ -100,9 +86,10 @@ void RiveQSGRHIRenderNode::renderOffscreen()
     if (!m_displayBuffer || m_rect.width() == 0 || m_rect.height() == 0)
         return;
 
-    if (!m_cleanUpTextureTarget) {
+    if (!m_offscreenDirty) {
         return;
     }
+    m_offscreenDirty = false;
 
     QSGRendererInterface *renderInterface = m_window->rendererInterface();
     QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
@@ -110,10 +97,7 @@ void RiveQSGRHIRenderNode::renderOffscreen()
     QRhiCommandBuffer *cb;
     rhi->beginOffscreenFrame(&cb);
     {
-        // clean our main texture
-        cb->beginPass(m_cleanUpTextureTarget, QColor(0, 0, 0, 0), { 1.0f, 0 });
-        cb->endPass();
-        // draw elements to our shared texture
+        // clears our shared texture and draws the elements to it
         m_renderer->render(cb);
     }
     rhi->endOffscreenFrame();
@@ -156,6 +140,71 @@ void RiveQSGRHIRenderNode::releaseResources()
     Q_ASSERT(m_cleanupList.empty());
 }
 
+void RiveQSGRHIRenderNode::releaseDisplayBuffer()
+{
+    if (m_displayBuffer) {
+        m_cleanupList.removeAll(m_displayBuffer);
+        m_displayBuffer->destroy();
+        m_displayBuffer->deleteLater();
+        m_displayBuffer = nullptr;
+    }
+
+    // the bindings refer to the display buffer
+    if (m_resourceBindings) {
+        m_cleanupList.removeAll(m_resourceBindings);
+        m_resourceBindings->destroy();
+        m_resourceBindings->deleteLater();
+        m_resourceBindings = nullptr;
+    }
+
+    m_shrinkFrameCount = 0;
+}
+
+void RiveQSGRHIRenderNode::releaseSampler()
+{
+    if (m_sampler) {
+        m_cleanupList.removeAll(m_sampler);
+        m_sampler->destroy();
+        m_sampler->deleteLater();
+        m_sampler = nullptr;
+    }
+
+    // the bindings refer to the sampler
+    if (m_resourceBindings) {
+        m_cleanupList.removeAll(m_resourceBindings);
+        m_resourceBindings->destroy();
+        m_resourceBindings->deleteLater();
+        m_resourceBindings = nullptr;
+    }
+}
+
+QRect RiveQSGRHIRenderNode::damagedRect(const std::vector<RiveQtDisplayList::Draw> &draws) const
+{
+    // draws are matched by their position in the frame, a draw added or removed damages all draws after it
+    QRectF damage;
+    const size_t drawCount = std::max(draws.size(), m_lastDraws.size());
+    for (size_t i = 0; i < drawCount; ++i) {
+        const bool drawn = i < draws.size();
+        const bool wasDrawn = i < m_lastDraws.size();
+        if (drawn && wasDrawn && draws[i].hash == m_lastDraws[i].hash && draws[i].bounds == m_lastDraws[i].bounds) {
+            continue;
+        }
+        if (drawn) {
+            damage |= draws[i].bounds;
+        }
+        if (wasDrawn) {
+            damage |= m_lastDraws[i].bounds;
+        }
+    }
+
+    if (damage.isEmpty()) {
+        return QRect();
+    }
+
+    // antialiased edges reach a bit further than the geometry
+    return m_artboardMatrix.mapRect(damage).toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
 QSGRenderNode::RenderingFlags RiveQSGRHIRenderNode::flags() const
 {
     // We are rendering 2D content directly into the scene graph
@@ -181,16 +230,60 @@ void RiveQSGRHIRenderNode::prepare()
     Q_ASSERT(swapChain);
     Q_ASSERT(rhi);
 
+    // one pixel per pixel of the window, unless renderScale asks for less or for supersampling
+    const qreal devicePixelRatio = m_window->effectiveDevicePixelRatio();
+    const qreal renderScale = m_renderScale > 0 ? m_renderScale : devicePixelRatio;
+    const int maximumSize = rhi->resourceLimit(QRhi::TextureSizeMax);
+
+    const QSize contentSize = (m_rect.size() * renderScale).toSize().boundedTo(QSize(maximumSize, maximumSize));
+    if (contentSize != m_contentSize) {
+        m_contentSize = contentSize;
+        m_viewportDirty = true;
+        // paths get flattened for the new scale
+        requireRedraw();
+    }
+
+    // scaling the texture to the window needs filtering, at the device pixel ratio every texel matches a pixel of the window
+    const bool linearSampling = renderScale != devicePixelRatio;
+    if (linearSampling != m_linearSampling) {
+        m_linearSampling = linearSampling;
+        releaseSampler();
+    }
+
+    QSize requiredSize = displayBufferSize(contentSize).boundedTo(QSize(maximumSize, maximumSize));
+    if (m_displayBuffer) {
+        const QSize currentSize = m_displayBuffer->pixelSize();
+        const bool grows = requiredSize.width() > currentSize.width() || requiredSize.height() > currentSize.height();
+        m_shrinkFrameCount = !grows && requiredSize != currentSize ? m_shrinkFrameCount + 1 : 0;
+
+        if (grows) {
+            // a side that got smaller keeps its size, until the whole display buffer shrinks
+            requiredSize = requiredSize.expandedTo(currentSize);
+            releaseDisplayBuffer();
+        } else if (m_shrinkFrameCount >= shrinkDelayFrames) {
+            releaseDisplayBuffer();
+        }
+    }
+
     if (!m_displayBuffer) {
-        m_displayBuffer = rhi->newTexture(QRhiTexture::RGBA8, QSize(m_rect.width(), m_rect.height()), 1,
-                                          QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
+        m_displayBuffer =
+            rhi->newTexture(QRhiTexture::RGBA8, requiredSize, 1, QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource);
         m_displayBuffer->create();
         m_cleanupList.append(m_displayBuffer);
 
         if (m_renderer) {
             m_renderer->updateViewPort(m_rect, m_displayBuffer);
-            m_renderer->setRiveRect({ m_topLeftRivePosition, m_riveSize });
         }
+        m_viewportDirty = true;
+        // the nodes of the renderer are gone
+        requireRedraw();
+    }
+
+    if (m_viewportDirty && m_renderer) {
+        m_renderer->setViewportRect(m_rect);
+        m_renderer->setContentSize(m_contentSize);
+        m_renderer->setRiveRect({ m_topLeftRivePosition, m_riveSize });
+        m_viewportDirty = false;
     }
 
     if (m_artboardInstance.expired()) {
@@ -204,7 +297,7 @@ void RiveQSGRHIRenderNode::prepare()
         return;
     }
 
-    m_renderer->recycleRiveNodes();
+    m_renderer->setFillMethod(m_fillMethod);
 
     m_renderer->updateArtboardSize(QSize(artboardInstance->width(), artboardInstance->height()));
 
@@ -222,21 +315,25 @@ void RiveQSGRHIRenderNode::prepare()
 
         projMatrix.scale(window2itemScaleX, window2itemScaleY);
 
-        QMatrix4x4 combinedMatrix = projMatrix;
+        QMatrix4x4 artboardMatrix;
 
-        combinedMatrix.translate(m_topLeftRivePosition.x(), m_topLeftRivePosition.y());
+        artboardMatrix.translate(m_topLeftRivePosition.x(), m_topLeftRivePosition.y());
 
         const auto item2artboardScaleX = m_rect.width() / artboardInstance->width();
         const auto item2artboardScaleY = m_rect.height() / artboardInstance->height();
+        // pixels per artboard unit, curves get flattened finer the larger the artboard is shown
+        float viewScale = 1.f;
 
         switch (m_fillMode) {
         case RiveRenderSettings::Stretch: {
-            combinedMatrix.scale(item2artboardScaleX, item2artboardScaleY);
+            artboardMatrix.scale(item2artboardScaleX, item2artboardScaleY);
+            viewScale = qMax(item2artboardScaleX, item2artboardScaleY);
             break;
         }
         case RiveRenderSettings::PreserveAspectCrop: {
             const auto scaleFactor = qMax(item2artboardScaleX, item2artboardScaleY);
-            combinedMatrix.scale(scaleFactor, scaleFactor);
+            artboardMatrix.scale(scaleFactor, scaleFactor);
+            viewScale = scaleFactor;
             break;
         }
         default:
@@ -260,23 +357,43 @@ void RiveQSGRHIRenderNode::prepare()
                 bottom = 1.0 - heightFactor;
             }
 
-            combinedMatrix.scale(scaleFactor, scaleFactor);
+            artboardMatrix.scale(scaleFactor, scaleFactor);
+            viewScale = scaleFactor;
             break;
         }
         }
 
+        const QMatrix4x4 combinedMatrix = projMatrix * artboardMatrix;
+        m_artboardMatrix = QMatrix4x4();
+        m_artboardMatrix.scale(renderScale, renderScale);
+        m_artboardMatrix *= artboardMatrix;
+
         m_renderer->setProjectionMatrix(&projMatrix, &combinedMatrix);
+        m_renderer->setViewScale(viewScale * renderScale);
+
+        if (combinedMatrix != m_combinedMatrix) {
+            m_combinedMatrix = combinedMatrix;
+            requireRedraw();
+        }
     }
 
-    artboardInstance->draw(m_renderer);
+    // without a new frame, or one that looks like the last one, the texture keeps showing what it has
+    if (recordDisplayList() && (m_redrawRequired || m_displayList->contentHash() != m_contentHash)) {
+        // the damage adds up until the renderer drew it
+        if (m_redrawRequired) {
+            m_renderer->damageAll();
+        } else {
+            m_renderer->addDamage(damagedRect(m_displayList->draws()));
+        }
 
-    if (!m_cleanUpTextureTarget) {
-        QRhiColorAttachment colorAttachment(m_displayBuffer);
-        QRhiTextureRenderTargetDescription desc(colorAttachment);
-        m_cleanUpTextureTarget = rhi->newTextureRenderTarget(desc);
+        m_contentHash = m_displayList->contentHash();
+        m_lastDraws = m_displayList->draws();
+        m_redrawRequired = false;
 
-        m_cleanUpTextureTarget->create();
-        m_cleanupList.append(m_cleanUpTextureTarget);
+        m_renderer->recycleRiveNodes();
+        m_displayList->replay(m_renderer);
+        m_renderer->finishDrawing();
+        m_offscreenDirty = true;
     }
 
     QRhiResourceUpdateBatch *resourceUpdates = rhi->nextResourceUpdateBatch();
@@ -316,14 +433,14 @@ void RiveQSGRHIRenderNode::prepare()
     }
 
     if (!m_sampler) {
-        m_sampler = rhi->newSampler(QRhiSampler::Nearest, QRhiSampler::Nearest, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                    QRhiSampler::ClampToEdge);
+        const QRhiSampler::Filter filter = m_linearSampling ? QRhiSampler::Linear : QRhiSampler::Nearest;
+        m_sampler = rhi->newSampler(filter, filter, QRhiSampler::None, QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge);
         m_sampler->create();
         m_cleanupList.append(m_sampler);
     }
 
     if (!m_uniformBuffer) {
-        m_uniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 88);
+        m_uniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 96);
         m_uniformBuffer->create();
         m_cleanupList.append(m_uniformBuffer);
     }
@@ -390,6 +507,9 @@ void RiveQSGRHIRenderNode::prepare()
 
     float opacity = inheritedOpacity();
     int flipped = rhi->isYUpInFramebuffer() ? 1 : 0;
+    // part of the display buffer the item is drawn into
+    float contentScaleX = float(m_contentSize.width()) / m_displayBuffer->pixelSize().width();
+    float contentScaleY = float(m_contentSize.height()) / m_displayBuffer->pixelSize().height();
 
     resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 0, 64, mvp.constData());
     resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 64, 4, &opacity);
@@ -398,6 +518,8 @@ void RiveQSGRHIRenderNode::prepare()
     resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 76, 4, &right);
     resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 80, 4, &top);
     resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 84, 4, &bottom);
+    resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 88, 4, &contentScaleX);
+    resourceUpdates->updateDynamicBuffer(m_uniformBuffer, 92, 4, &contentScaleY);
 
     swapChain->currentFrameCommandBuffer()->resourceUpdate(resourceUpdates);
 }
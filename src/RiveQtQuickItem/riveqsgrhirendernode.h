@@ -19,6 +19,7 @@
 
 #include "datatypes.h"
 #include "riveqsgrendernode.h"
+#include "renderer/riveqtdisplaylist.h"
 
 //-----------------
 class RiveQtQuickItem;
@@ -32,7 +33,11 @@ public:
     virtual ~RiveQSGRHIRenderNode();
 
     void setRect(const QRectF &bounds) override;
-    void setFillMode(const RiveRenderSettings::FillMode mode) { m_fillMode = mode; }
+    void setFillMode(const RiveRenderSettings::FillMode mode)
+    {
+        m_fillMode = mode;
+        requireRedraw();
+    }
 
     void renderOffscreen() override;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -46,6 +51,11 @@ public:
     QSGRenderNode::StateFlags changedStates() const override;
 
 protected:
+    // area of the display buffer, in pixels, covered by draws that differ from the draws of the last recorded frame
+    QRect damagedRect(const std::vector<RiveQtDisplayList::Draw> &draws) const;
+    void releaseDisplayBuffer();
+    void releaseSampler();
+
     QRhiBuffer *m_vertexBuffer { nullptr };
     QRhiBuffer *m_texCoordBuffer { nullptr };
     QRhiBuffer *m_uniformBuffer { nullptr };
@@ -63,8 +73,18 @@ protected:
 
     RiveQtRhiRenderer *m_renderer { nullptr };
     QRhiTexture *m_displayBuffer { nullptr };
-    QRhiTextureRenderTarget *m_cleanUpTextureTarget { nullptr };
 
     bool m_verticesDirty = true;
+    bool m_viewportDirty = false;
+    bool m_linearSampling = false;
+    QSize m_contentSize; // pixels of the display buffer the item is drawn into
+    // frames the item fits into a smaller display buffer, it gets replaced after some of those
+    int m_shrinkFrameCount { 0 };
+    // the texture still holds the last frame, renderOffscreen has nothing to do
+    bool m_offscreenDirty { true };
+    quint64 m_contentHash { 0 }; // of the display list the texture shows
+    std::vector<RiveQtDisplayList::Draw> m_lastDraws; // of the display list the texture shows
+    QMatrix4x4 m_combinedMatrix;
+    QMatrix4x4 m_artboardMatrix; // artboard to display buffer pixels
     RiveRenderSettings::FillMode m_fillMode;
 };
@@ -13,6 +13,7 @@ RiveQSGSoftwareRenderNode::RiveQSGSoftwareRenderNode(QQuickWindow *window, std::
                                                      const QRectF &geometry)
     : RiveQSGRenderNode(window, artboardInstance, geometry)
 {
+    m_displayList = std::make_unique<RiveQtDisplayList>(RiveQtFactory::RiveQtRenderType::QPainterRenderer);
 }
 
 QRectF RiveQSGSoftwareRenderNode::rect() const
@@ -98,7 +99,8 @@ void RiveQSGSoftwareRenderNode::renderSoftware(const RenderState *state)
 
         painter->save();
         {
-            artboardInstance->draw(&m_renderer);
+            recordDisplayList();
+            m_displayList->replay(&m_renderer);
         }
         painter->restore();
     }
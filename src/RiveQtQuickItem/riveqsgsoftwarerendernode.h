@@ -16,6 +16,7 @@
 
 #include "riveqsgrendernode.h"
 #include "renderer/riveqtpainterrenderer.h"
+#include "renderer/riveqtdisplaylist.h"
 
 class RiveQtQuickItem;
 class QQuickWindow;
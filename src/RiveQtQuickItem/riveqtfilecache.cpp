@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QResource>
+
+#include "riveqtfilecache.h"
+#include "renderer/riveqtfactory.h"
+#include "rqqplogging.h"
+
+namespace {
+// Everything a shared rive::File depends on. The file is declared last so it is destroyed first.
+struct RiveQtFileData
+{
+    explicit RiveQtFileData(const RiveRenderSettings &renderSettings)
+        : factory(renderSettings)
+    {
+    }
+
+    // Makes the source available in bytes without copying it if possible:
+    // compiled in resources are used in place, files on disk get memory mapped.
+    bool load(const QString &source)
+    {
+        if (source.startsWith(QLatin1Char(':'))) {
+            const QResource resource(source);
+            if (resource.isValid() && resource.compressionAlgorithm() == QResource::NoCompression) {
+                // lives as long as the resource is registered, which for compiled in resources is the whole process
+                bytes = rive::Span<const uint8_t>(resource.data(), static_cast<size_t>(resource.size()));
+                return true;
+            }
+        }
+
+        mappedFile.setFileName(source);
+        if (!mappedFile.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        // the mapping stays valid after closing the file, it is released together with mappedFile
+        if (uchar *mappedData = mappedFile.map(0, mappedFile.size())) {
+            bytes = rive::Span<const uint8_t>(mappedData, static_cast<size_t>(mappedFile.size()));
+            mappedFile.close();
+            return true;
+        }
+
+        // compressed resources and files that cannot be mapped end up here
+        qCDebug(rqqpItem) << "Cannot map" << source << "- reading it instead";
+        data = mappedFile.readAll();
+        mappedFile.close();
+        bytes = rive::Span<const uint8_t>(reinterpret_cast<const uint8_t *>(data.constData()), static_cast<size_t>(data.size()));
+        return true;
+    }
+
+    RiveQtFactory factory;
+    QFile mappedFile;
+    QByteArray data;
+    rive::Span<const uint8_t> bytes;
+    std::unique_ptr<rive::File> file;
+};
+}
+
+RiveQtFileCache *RiveQtFileCache::instance()
+{
+    static RiveQtFileCache cache;
+    return &cache;
+}
+
+std::shared_ptr<rive::File> RiveQtFileCache::acquire(const QString &source, const RiveRenderSettings &renderSettings,
+                                                     rive::ImportResult *importResult, const ProgressCallback &progress)
+{
+    const QString key = cacheKey(source, renderSettings);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        pruneExpiredEntries();
+
+        const auto it = m_entries.constFind(key);
+        if (it != m_entries.constEnd()) {
+            if (auto file = it->file.lock()) {
+                m_hits++;
+                m_savedBytes += it->bytes;
+                qCDebug(rqqpItem) << "File cache hit for" << source << "- hits:" << m_hits << "misses:" << m_misses
+                                  << "saved bytes:" << m_savedBytes;
+                if (importResult) {
+                    *importResult = rive::ImportResult::success;
+                }
+                return file;
+            }
+        }
+    }
+
+    // the import happens without holding the lock, importing big files takes a while
+    auto fileData = std::make_shared<RiveQtFileData>(renderSettings);
+
+    if (!fileData->load(source)) {
+        qCWarning(rqqpItem) << "Failed to open the file " << source;
+        if (importResult) {
+            *importResult = rive::ImportResult::malformed;
+        }
+        return nullptr;
+    }
+
+    if (progress) {
+        progress(0.3);
+    }
+
+    rive::ImportResult result;
+    fileData->file = rive::File::import(fileData->bytes, &fileData->factory, &result);
+
+    if (importResult) {
+        *importResult = result;
+    }
+
+    if (progress) {
+        progress(0.9);
+    }
+
+    if (result != rive::ImportResult::success || !fileData->file) {
+        return nullptr;
+    }
+
+    // aliasing constructor, the returned pointer keeps factory and source bytes alive together with the file
+    std::shared_ptr<rive::File> sharedFile(fileData, fileData->file.get());
+
+    QMutexLocker locker(&m_mutex);
+
+    // Someone else might have imported the same source in the meantime, prefer the instance that is already in use.
+    // This still counts as a miss, the import was done anyways and nothing got saved by the cache.
+    auto &entry = m_entries[key];
+    if (auto existingFile = entry.file.lock()) {
+        m_misses++;
+        qCDebug(rqqpItem) << "File cache miss for" << source << "- imported concurrently, using the instance already in use";
+        return existingFile;
+    }
+
+    entry.file = sharedFile;
+    entry.bytes = static_cast<qint64>(fileData->bytes.size());
+    m_misses++;
+
+    qCDebug(rqqpItem) << "File cache miss for" << source << "- hits:" << m_hits << "misses:" << m_misses << "imported bytes:" << entry.bytes;
+
+    return sharedFile;
+}
+
+RiveQtFileCache::Statistics RiveQtFileCache::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    Statistics statistics;
+    statistics.hits = m_hits;
+    statistics.misses = m_misses;
+    statistics.savedBytes = m_savedBytes;
+
+    for (const auto &entry : m_entries) {
+        if (entry.file.expired()) {
+            continue;
+        }
+        statistics.residentFiles++;
+        statistics.residentBytes += entry.bytes;
+    }
+
+    return statistics;
+}
+
+QString RiveQtFileCache::cacheKey(const QString &source, const RiveRenderSettings &renderSettings) const
+{
+    const QFileInfo fileInfo(source);
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+
+    return QStringLiteral("%1|%2|%3|%4|%5")
+        .arg(canonicalPath.isEmpty() ? source : canonicalPath)
+        .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+        .arg(fileInfo.size())
+        .arg(static_cast<int>(renderSettings.graphicsApi))
+        .arg(static_cast<int>(renderSettings.renderQuality));
+}
+
+void RiveQtFileCache::pruneExpiredEntries()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->file.expired()) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
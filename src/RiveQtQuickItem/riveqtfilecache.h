@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <rive/file.hpp>
+
+#include "datatypes.h"
+
+// Process wide cache of imported rive files.
+//
+// Items that show the same .riv source share a single rive::File (and with it the decoded images and fonts),
+// every item only creates its own ArtboardInstance from it.
+// The cache itself only holds weak references, a file is released as soon as the last item drops it.
+// Source data is not copied where possible: files on disk are memory mapped and uncompressed
+// resources are used in place, both stay alive as long as the shared rive::File.
+class RiveQtFileCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits { 0 };
+        quint64 misses { 0 };
+        int residentFiles { 0 };
+        qint64 residentBytes { 0 }; // size of the source data of all files alive right now, mapped or read
+        qint64 savedBytes { 0 }; // source data that did not have to be read and imported again thanks to a hit
+    };
+
+    static RiveQtFileCache *instance();
+
+    using ProgressCallback = std::function<void(qreal progress)>;
+
+    // Returns the shared file for source, importing it if there is no living instance yet.
+    // The render settings are part of the key, since the factory used for importing
+    // decides which kind of paths the artboard instances will create.
+    // Thread safe, may be called from a worker thread. The progress callback is invoked from the calling thread.
+    std::shared_ptr<rive::File> acquire(const QString &source, const RiveRenderSettings &renderSettings,
+                                        rive::ImportResult *importResult = nullptr, const ProgressCallback &progress = nullptr);
+
+    Statistics statistics() const;
+
+private:
+    struct CacheEntry
+    {
+        std::weak_ptr<rive::File> file;
+        qint64 bytes { 0 };
+    };
+
+    RiveQtFileCache() = default;
+
+    QString cacheKey(const QString &source, const RiveRenderSettings &renderSettings) const;
+    void pruneExpiredEntries();
+
+    mutable QMutex m_mutex;
+    QHash<QString, CacheEntry> m_entries;
+
+    quint64 m_hits { 0 };
+    quint64 m_misses { 0 };
+    qint64 m_savedBytes { 0 };
+};
@@ -3,8 +3,11 @@
 // SPDX-FileCopyrightText: 2023 basysKom GmbH
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
+#include <atomic>
+#include <cmath>
 #include <optional>
 
+#include <QVarLengthArray>
 #include <QVector2D>
 #include <QMatrix2x2>
 #include <QtMath>
@@ -13,26 +16,65 @@
 
 #include "rqqplogging.h"
 #include "riveqtpath.h"
+#include "riveqtpathkernels.h"
+#include "riveqttessellator.h"
 #include "riveqtutils.h"
 
+namespace {
+std::atomic<quint64> nextPathId { 1 };
+
+// Scratch memory shared by all paths of a thread, once large enough rebuilding geometry does not allocate anymore.
+struct StrokeScratch
+{
+    QVector<QVector2D> starts;
+    QVector<QVector2D> ends;
+    QVector<QVector2D> normals;
+    QVector<QVector2D> endNormals;
+    QVector<QVector2D> joins;
+    QVector<QVector2D> caps;
+};
+
+std::atomic<quint64> strokeCacheHits { 0 };
+std::atomic<quint64> strokeCacheMisses { 0 };
+
+thread_local StrokeScratch strokeScratch;
+thread_local RiveQtTessellator fillTessellator;
+thread_local QVector<QVector2D> coverScratch;
+}
+
 RiveQtPath::RiveQtPath(const unsigned segmentCount)
+    : m_id(nextPathId++)
 {
     m_qPainterPath.setFillRule(Qt::FillRule::WindingFill);
     setSegmentCount(segmentCount);
-    m_pathSegmentOutlineDataDirty = true;
+    m_outlinePointsDirty = true;
     m_pathSegmentDataDirty = true;
 }
 
 RiveQtPath::RiveQtPath(const RiveQtPath &other)
+    : m_id(nextPathId++)
 {
     m_qPainterPath = other.m_qPainterPath;
     m_pathVertices = other.m_pathVertices;
-    m_pathSegmentsOutlineData = other.m_pathSegmentsOutlineData;
-    m_pathOutlineVertices = other.m_pathOutlineVertices;
+    m_outlinePoints = other.m_outlinePoints;
+    m_outlineSubPaths = other.m_outlineSubPaths;
+    m_strokeCache = other.m_strokeCache;
+    m_strokeCacheUseCounter = other.m_strokeCacheUseCounter;
+    m_strokeCenterline = other.m_strokeCenterline;
     m_segmentCount = other.m_segmentCount;
+    m_pixelTolerance = other.m_pixelTolerance;
+    m_tolerance = other.m_tolerance;
+    m_fillMethod = other.m_fillMethod;
+
+    // the copied caches are only valid together with the state they were built from
+    m_pathSegmentDataDirty = other.m_pathSegmentDataDirty;
+    m_outlinePointsDirty = other.m_outlinePointsDirty;
+    m_strokeCenterlineDirty = other.m_strokeCenterlineDirty;
+    m_generation = other.m_generation;
 }
 
 RiveQtPath::RiveQtPath(const rive::RawPath &rawPath, rive::FillRule fillRule, const unsigned segmentCount)
+    : m_id(nextPathId++)
 {
     m_qPainterPath.clear();
     m_qPainterPath.setFillRule(RiveQtUtils::riveFillRuleToQt(fillRule));
@@ -61,29 +103,37 @@ RiveQtPath::RiveQtPath(const rive::RawPath &rawPath, rive::FillRule fillRule, co
             break;
         }
     }
-    m_pathSegmentOutlineDataDirty = true;
+    m_outlinePointsDirty = true;
     m_pathSegmentDataDirty = true;
 }
 
 void RiveQtPath::rewind()
 {
     m_pathVertices.clear();
-    m_pathSegmentsOutlineData.clear();
+    m_outlinePoints.resize(0);
+    m_outlineSubPaths.resize(0);
     m_qPainterPath.clear();
-    m_pathSegmentOutlineDataDirty = true;
+    markDirty();
+}
+
+void RiveQtPath::markDirty()
+{
+    m_outlinePointsDirty = true;
+    m_strokeCenterlineDirty = true;
     m_pathSegmentDataDirty = true;
+    m_generation++;
 }
 
 void RiveQtPath::fillRule(rive::FillRule value)
 {
-    switch (value) {
-    case rive::FillRule::evenOdd:
-        m_qPainterPath.setFillRule(Qt::FillRule::OddEvenFill);
-        break;
-    case rive::FillRule::nonZero:
-        m_qPainterPath.setFillRule(Qt::FillRule::WindingFill);
-        break;
+    // fills set their rule every time they get drawn, only a real change makes the geometry outdated
+    const Qt::FillRule qtFillRule = RiveQtUtils::riveFillRuleToQt(value);
+    if (m_qPainterPath.fillRule() == qtFillRule) {
+        return;
     }
+
+    m_qPainterPath.setFillRule(qtFillRule);
+    markDirty();
 }
 
 void RiveQtPath::addRenderPath(rive::RenderPath *path, const rive::Mat2D &transform)
@@ -100,13 +150,13 @@ void RiveQtPath::addRenderPath(rive::RenderPath *path, const rive::Mat2D &transf
     QPainterPath qPath = qtPath->toQPainterPath() * qTransform;
     m_qPainterPath.addPath(qPath);
 
-    m_pathSegmentOutlineDataDirty = true;
-    m_pathSegmentDataDirty = true;
+    markDirty();
 }
 
 void RiveQtPath::setQPainterPath(QPainterPath path)
 {
     m_qPainterPath = path;
+    markDirty();
 }
 
 std::optional<QVector2D> calculateIntersection(const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, const QVector2D &p4)
@@ -142,9 +192,51 @@ void RiveQtPath::setSegmentCount(const unsigned segmentCount)
     } else {
         m_segmentCount = segmentCount;
     }
+    markDirty();
+}
+
+void RiveQtPath::setPixelTolerance(const float pixelTolerance)
+{
+    if (pixelTolerance <= 0.f) {
+        qCDebug(rqqpRendering) << "Pixel tolerance must be larger than 0.";
+        return;
+    }
+    m_pixelTolerance = pixelTolerance;
+}
+
+void RiveQtPath::setDeviceScale(const float deviceScale)
+{
+    const float tolerance = toleranceForDeviceScale(deviceScale);
+    if (tolerance == m_tolerance) {
+        return;
+    }
+
+    m_tolerance = tolerance;
+    markDirty();
+}
+
+float RiveQtPath::toleranceForDeviceScale(const float deviceScale) const
+{
+    if (deviceScale <= 0.f || !qIsFinite(deviceScale)) {
+        return m_tolerance;
+    }
+
+    // Snap to powers of two, so animated scales only flatten the path again once the scale
+    // changed by a factor of two and not in every frame. Rounding down keeps the error within the tolerance.
+    return std::exp2(std::floor(std::log2(m_pixelTolerance / deviceScale)));
+}
+
+void RiveQtPath::setFillMethod(const RiveRenderSettings::FillMethod fillMethod)
+{
+    if (m_fillMethod == fillMethod) {
+        return;
+    }
+
+    m_fillMethod = fillMethod;
+    markDirty();
 }
 
-QVector<QVector<QVector2D>> RiveQtPath::toVertices()
+const RiveQtPathGeometry &RiveQtPath::toVertices()
 {
     if (m_pathSegmentDataDirty) {
         updatePathSegmentsData();
@@ -152,38 +244,70 @@ QVector<QVector<QVector2D>> RiveQtPath::toVertices()
     return m_pathVertices;
 }
 
-QVector<QVector<QVector2D>> RiveQtPath::toVerticesLine(const QPen &pen)
+const RiveQtPathGeometry &RiveQtPath::toVerticesLine(const QPen &pen, quint64 strokeGeneration)
 {
-    if (!m_pathSegmentOutlineDataDirty) {
-        return m_pathOutlineVertices;
+    const float width = pen.widthF();
+    const Qt::PenJoinStyle join = pen.joinStyle();
+    const Qt::PenCapStyle cap = pen.capStyle();
+
+    // Take the entry of this pen, otherwise the least recently used one.
+    // Entries of an older path generation are outdated anyways, they are reused first.
+    const auto isOutdated = [this](const StrokeCacheEntry &cached) { return cached.lastUsed == 0 || cached.pathGeneration != m_generation; };
+    StrokeCacheEntry *entry = nullptr;
+    for (StrokeCacheEntry &candidate : m_strokeCache) {
+        if (candidate.lastUsed != 0 && candidate.pathGeneration == m_generation && candidate.width == width && candidate.join == join
+            && candidate.cap == cap && candidate.segmentCount == m_segmentCount && candidate.strokeGeneration == strokeGeneration) {
+            strokeCacheHits++;
+            candidate.lastUsed = ++m_strokeCacheUseCounter;
+            return candidate.geometry;
+        }
+
+        if (!entry || (isOutdated(candidate) && !isOutdated(*entry))
+            || (isOutdated(candidate) == isOutdated(*entry) && candidate.lastUsed < entry->lastUsed)) {
+            entry = &candidate;
+        }
     }
 
-    updatePathSegmentsOutlineData();
-    m_pathOutlineVertices.clear();
+    strokeCacheMisses++;
 
-    // Early exit, nothing to do.
-    if (m_pathSegmentsOutlineData.isEmpty()) {
-        return m_pathOutlineVertices;
+    entry->width = width;
+    entry->join = join;
+    entry->cap = cap;
+    entry->segmentCount = m_segmentCount;
+    entry->strokeGeneration = strokeGeneration;
+    entry->pathGeneration = m_generation;
+    entry->lastUsed = ++m_strokeCacheUseCounter;
+    entry->geometry.clear();
+
+    if (m_outlinePointsDirty) {
+        updatePathSegmentsOutlineData();
     }
 
-    updatePathOutlineVertices(pen);
-    m_pathSegmentOutlineDataDirty = false;
+    if (!m_outlineSubPaths.isEmpty()) {
+        updatePathOutlineVertices(pen, entry->geometry);
+    }
 
-    return m_pathOutlineVertices;
+    return entry->geometry;
 }
 
-QPointF RiveQtPath::cubicBezier(const QPointF &startPoint, const QPointF &controlPoint1, const QPointF &controlPoint2,
-                                const QPointF &endPoint, qreal t)
+RiveQtPath::StrokeCacheStatistics RiveQtPath::strokeCacheStatistics()
 {
-    qreal oneMinusT = 1 - t;
-    qreal oneMinusTSquared = oneMinusT * oneMinusT;
-    qreal oneMinusTCubed = oneMinusTSquared * oneMinusT;
-    qreal tSquared = t * t;
-    qreal tCubed = tSquared * t;
-
-    QPointF point = oneMinusTCubed * startPoint + 3 * oneMinusTSquared * t * controlPoint1 + 3 * oneMinusT * tSquared * controlPoint2
-        + tCubed * endPoint;
-    return point;
+    StrokeCacheStatistics statistics;
+    statistics.hits = strokeCacheHits;
+    statistics.misses = strokeCacheMisses;
+    return statistics;
+}
+
+const RiveQtPathGeometry &RiveQtPath::toStrokeCenterline()
+{
+    if (m_strokeCenterlineDirty) {
+        if (m_outlinePointsDirty) {
+            updatePathSegmentsOutlineData();
+        }
+        updateStrokeCenterline();
+        m_strokeCenterlineDirty = false;
+    }
+    return m_strokeCenterline;
 }
 
 QVector2D cubicBezierTangent(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3, const float t)
@@ -194,55 +318,69 @@ QVector2D cubicBezierTangent(const QPointF &p0, const QPointF &p1, const QPointF
 
 void RiveQtPath::updatePathSegmentsOutlineData()
 {
-    m_pathSegmentsOutlineData.clear();
+    m_outlinePoints.resize(0);
+    m_outlineSubPaths.resize(0);
 
     if (m_qPainterPath.isEmpty()) {
-        m_pathSegmentOutlineDataDirty = false;
+        m_outlinePointsDirty = false;
         return;
     }
 
-    QVector<PathDataPoint> pathDataEnhanced;
-    pathDataEnhanced.reserve(m_qPainterPath.elementCount());
+    m_outlinePoints.reserve(m_qPainterPath.elementCount());
+
+    // sub paths with a single point are dropped again
+    int subPathStart = 0;
+    const auto finishSubPath = [this, &subPathStart]() {
+        if (m_outlinePoints.size() - subPathStart > 1) {
+            m_outlineSubPaths.append(subPathStart);
+        } else {
+            m_outlinePoints.resize(subPathStart);
+        }
+        subPathStart = m_outlinePoints.size();
+    };
 
     const QPointF &point = m_qPainterPath.elementAt(0);
     const QVector2D &centerPoint = QVector2D(point.x(), point.y());
     int currentStepIndex { 0 };
 
     // Add the current point
-    pathDataEnhanced.append({ centerPoint, QVector2D(), currentStepIndex });
+    m_outlinePoints.append({ centerPoint, QVector2D(), currentStepIndex });
 
     for (int i = 1; i < m_qPainterPath.elementCount(); ++i) {
         QPainterPath::Element element = m_qPainterPath.elementAt(i);
 
         switch (element.type) {
         case QPainterPath::MoveToElement:
-            if (pathDataEnhanced.size() > 1)
-                m_pathSegmentsOutlineData.append(pathDataEnhanced);
-            pathDataEnhanced.clear();
+            finishSubPath();
             currentStepIndex = 0;
-            pathDataEnhanced.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
+            m_outlinePoints.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
             ++currentStepIndex;
             break;
 
         case QPainterPath::LineToElement:
-            pathDataEnhanced.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
+            m_outlinePoints.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
             ++currentStepIndex;
             break;
 
         case QPainterPath::CurveToElement: {
-            const QPointF &startPoint = pathDataEnhanced.last().point.toPointF();
+            const QPointF startPoint = m_outlinePoints.last().point.toPointF(); // copy, appending might reallocate
             const QPointF &controlPoint1 = element;
             const QPointF &controlPoint2 = m_qPainterPath.elementAt(i + 1);
             const QPointF &endPoint = m_qPainterPath.elementAt(i + 2);
 
-            pathDataEnhanced.last().tangent = cubicBezierTangent(startPoint, controlPoint1, controlPoint2, endPoint, 0.f);
+            m_outlinePoints.last().tangent = cubicBezierTangent(startPoint, controlPoint1, controlPoint2, endPoint, 0.f);
+
+            const int segmentCount = RiveQtTessellator::curveSegments(QVector2D(startPoint), QVector2D(controlPoint1),
+                                                                      QVector2D(controlPoint2), QVector2D(endPoint), m_tolerance);
+
+            QVarLengthArray<float, 256> positions(2 * segmentCount);
+            QVarLengthArray<float, 256> tangents(2 * segmentCount);
+            RiveQtPathKernels::evaluateCubic(QVector2D(startPoint), QVector2D(controlPoint1), QVector2D(controlPoint2), QVector2D(endPoint),
+                                             segmentCount, positions.data(), tangents.data());
 
-            for (int j = 1; j <= m_segmentCount; ++j) {
-                const qreal t = static_cast<qreal>(j) / m_segmentCount;
-                const QPointF &point = cubicBezier(startPoint, controlPoint1, controlPoint2, endPoint, t);
-                //                pathData.append(QVector2D(point.x(), point.y()));
-                pathDataEnhanced.append({ QVector2D(point.x(), point.y()),
-                                          cubicBezierTangent(startPoint, controlPoint1, controlPoint2, endPoint, t), currentStepIndex });
+            for (int j = 0; j < segmentCount; ++j) {
+                m_outlinePoints.append({ QVector2D(positions[2 * j], positions[2 * j + 1]), QVector2D(tangents[2 * j], tangents[2 * j + 1]),
+                                         currentStepIndex });
             }
 
             i += 2; // Skip the next two control points, as we already processed them.
@@ -254,62 +392,90 @@ void RiveQtPath::updatePathSegmentsOutlineData()
         }
     }
 
-    m_pathSegmentsOutlineData.append(pathDataEnhanced);
-    m_pathSegmentOutlineDataDirty = false;
+    finishSubPath();
+    m_outlinePointsDirty = false;
+}
+
+int RiveQtPath::collectOutlineSegments(const PathDataPoint *pathData, int pointCount, bool closed)
+{
+    const int endIndex = closed ? pointCount : pointCount - 1;
+
+    strokeScratch.starts.resize(endIndex);
+    strokeScratch.ends.resize(endIndex);
+    strokeScratch.normals.resize(endIndex);
+    strokeScratch.endNormals.resize(endIndex);
+
+    for (int i = 0; i < endIndex; ++i) {
+        const int nextI = (i + 1) % pointCount;
+        strokeScratch.starts[i] = pathData[i].point;
+        strokeScratch.ends[i] = pathData[nextI].point; // if endIndex, take 0
+
+        if (pathData[i].tangent.isNull()) {
+            const QVector2D diff = strokeScratch.ends.at(i) - strokeScratch.starts.at(i);
+            strokeScratch.normals[i] = QVector2D(-diff.y(), diff.x()).normalized();
+        } else {
+            strokeScratch.normals[i] = QVector2D(-pathData[i].tangent.y(), pathData[i].tangent.x()).normalized();
+        }
+        if (pathData[nextI].tangent.isNull()) {
+            strokeScratch.endNormals[i] = strokeScratch.normals.at(i);
+        } else {
+            strokeScratch.endNormals[i] = QVector2D(-pathData[nextI].tangent.y(), pathData[nextI].tangent.x()).normalized();
+        }
+    }
+
+    return endIndex;
 }
 
-void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
+int RiveQtPath::joinedSegment(const PathDataPoint *pathData, int pointCount, bool closed, int index)
+{
+    const int endIndex = closed ? pointCount : pointCount - 1;
+    if (index >= endIndex - 1) {
+        return -1;
+    }
+
+    // points within a curve share their step index, only the ends of path elements need a join
+    const int nextI = (index + 1) % pointCount;
+    // the last segment of a closed path has no length, the join leads to the first one instead
+    const int next = closed && (index + 2) == pointCount ? 0 : index + 1;
+    return pathData[nextI].stepIndex != pathData[(next + 1) % pointCount].stepIndex ? next : -1;
+}
+
+void RiveQtPath::updatePathOutlineVertices(const QPen &pen, RiveQtPathGeometry &geometry)
 {
     const qreal lineWidth = pen.widthF();
     const Qt::PenJoinStyle &joinType = pen.joinStyle();
     const Qt::PenCapStyle &capStyle = pen.capStyle();
 
-    for (const auto &pathData : qAsConst(m_pathSegmentsOutlineData)) {
-        if (pathData.size() <= 1) {
-            continue;
-        }
+    QVector<QVector2D> &vertices = geometry.vertices;
 
-        QVector<QVector2D> lineDataSegment;
+    for (int subPath = 0; subPath < m_outlineSubPaths.size(); ++subPath) {
+        const int firstPoint = m_outlineSubPaths.at(subPath);
+        const int pointCount =
+            (subPath + 1 < m_outlineSubPaths.size() ? m_outlineSubPaths.at(subPath + 1) : m_outlinePoints.size()) - firstPoint;
+        const PathDataPoint *pathData = m_outlinePoints.constData() + firstPoint;
 
-        bool closed = false;
+        const bool closed = pathData[0].point == pathData[pointCount - 1].point;
 
-        if (pathData.first().point == pathData.last().point) {
-            closed = true;
-        }
+        // collect the normals of all segments first, so their quads get extruded in one batch
+        const int endIndex = collectOutlineSegments(pathData, pointCount, closed);
 
-        const int endIndex = closed ? pathData.count() : pathData.count() - 1;
+        // the quads of all segments come first, caps and joins follow
+        geometry.beginSubPath();
+        const int segmentStart = vertices.size();
+        vertices.resize(segmentStart + 6 * endIndex);
+        RiveQtPathKernels::extrudeSegments(reinterpret_cast<const float *>(strokeScratch.starts.constData()),
+                                           reinterpret_cast<const float *>(strokeScratch.ends.constData()),
+                                           reinterpret_cast<const float *>(strokeScratch.normals.constData()),
+                                           reinterpret_cast<const float *>(strokeScratch.endNormals.constData()), endIndex, lineWidth / 2.0,
+                                           reinterpret_cast<float *>(vertices.data() + segmentStart));
 
         for (int i = 0; i < endIndex; ++i) {
-            int nextI = (i + 1) % (pathData.count());
-            const QVector2D &p1 = pathData[i].point;
-            const QVector2D &p2 = pathData[nextI].point; // if endIndex, take 0
-            const auto &t1 = pathData[i].tangent;
-            const auto &t2 = pathData[nextI].tangent;
-
-            QVector2D normal, normal2;
-            const QVector2D diff = p2 - p1;
-
-            if (pathData.at(i).tangent.isNull()) {
-                normal = QVector2D(-diff.y(), diff.x()).normalized();
-            } else {
-                normal = QVector2D(-pathData.at(i).tangent.y(), pathData.at(i).tangent.x()).normalized();
-            }
-            if (pathData.at(nextI).tangent.isNull()) {
-                normal2 = normal;
-            } else {
-                normal2 = QVector2D(-pathData.at(nextI).tangent.y(), pathData.at(nextI).tangent.x()).normalized();
-            }
+            int nextI = (i + 1) % pointCount;
+            const QVector2D p1 = strokeScratch.starts.at(i);
+            const QVector2D p2 = strokeScratch.ends.at(i);
+            const QVector2D normal = strokeScratch.normals.at(i);
             const QVector2D offset = normal * (lineWidth / 2.0);
-            const QVector2D offset2 = normal2 * (lineWidth / 2.0);
-
-            // add the line segment
-            lineDataSegment.append(p1 + offset);
-            lineDataSegment.append(p1 - offset);
-            lineDataSegment.append(p2 + offset2);
-
-            lineDataSegment.append(p2 + offset2);
-            lineDataSegment.append(p2 - offset2);
-            lineDataSegment.append(p1 - offset);
+            const QVector2D offset2 = strokeScratch.endNormals.at(i) * (lineWidth / 2.0);
 
             if (!closed && (i == 0 || i == endIndex - 1)) {
                 switch (capStyle) {
@@ -325,39 +491,31 @@ void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
                     const float sPhi = sin(phi);
                     float rotation[4] = { cPhi, -sPhi, sPhi, cPhi };
 
-                    QVector<QVector2D> capVertices;
-                    capVertices.reserve(3 * numSegments);
-
                     QVector2D currentOffset = i == 0 ? offset : offset2;
                     const auto centerPoint = i == 0 ? p1 : p2;
 
                     for (int i = 0; i < numSegments; ++i) {
-                        capVertices.append(centerPoint + currentOffset);
-                        capVertices.append(centerPoint);
+                        vertices.append(centerPoint + currentOffset);
+                        vertices.append(centerPoint);
                         const auto tmp = rotation[0] * currentOffset[0] + rotation[1] * currentOffset[1];
                         currentOffset[1] = rotation[2] * currentOffset[0] + rotation[3] * currentOffset[1];
                         currentOffset[0] = tmp;
-                        capVertices.append(centerPoint + currentOffset);
+                        vertices.append(centerPoint + currentOffset);
                     }
-
-                    lineDataSegment = i == 0 ? capVertices + lineDataSegment : lineDataSegment + capVertices;
                     break;
                 }
                 case Qt::PenCapStyle::SquareCap: {
-                    if (lineDataSegment.size() < 6)
-                        break;
-
-                    const auto direction = i == 0 ? pathData.at(i).tangent : pathData.at(nextI).tangent;
+                    const auto direction = i == 0 ? pathData[i].tangent : pathData[nextI].tangent;
 
                     if (i == 0) {
-                        lineDataSegment[0] -= direction * lineWidth / 2.0;
-                        lineDataSegment[1] -= direction * lineWidth / 2.0;
-                        lineDataSegment[5] -= direction * lineWidth / 2.0;
+                        vertices[segmentStart] -= direction * lineWidth / 2.0;
+                        vertices[segmentStart + 1] -= direction * lineWidth / 2.0;
+                        vertices[segmentStart + 5] -= direction * lineWidth / 2.0;
                     } else { // is last element
-                        const auto end = lineDataSegment.size();
-                        lineDataSegment[end - 2] += direction * lineWidth / 2.0;
-                        lineDataSegment[end - 3] += direction * lineWidth / 2.0;
-                        lineDataSegment[end - 4] += direction * lineWidth / 2.0;
+                        const int quad = segmentStart + 6 * i;
+                        vertices[quad + 4] += direction * lineWidth / 2.0;
+                        vertices[quad + 3] += direction * lineWidth / 2.0;
+                        vertices[quad + 2] += direction * lineWidth / 2.0;
                     }
                     break;
                 }
@@ -366,19 +524,8 @@ void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
                     break;
                 }
             }
-            if (i < endIndex - 1) {
-                auto p3 = pathData[(i + 2) % pathData.count()].point;
-                auto t3 = pathData[(i + 2) % pathData.count()].tangent;
-                bool needsJoin = pathData[nextI].stepIndex != pathData[(i + 2) % pathData.count()].stepIndex;
-
-                if (closed && (i + 2) == pathData.count()) {
-                    p3 = pathData[(i + 3) % pathData.count()].point;
-                    t3 = pathData[(i + 3) % pathData.count()].tangent;
-                    needsJoin = pathData[nextI].stepIndex != pathData[(i + 3) % pathData.count()].stepIndex;
-                }
-
-                if (!needsJoin)
-                    continue;
+            if (const int next = joinedSegment(pathData, pointCount, closed, i); next >= 0) {
+                const auto p3 = strokeScratch.ends.at(next);
 
                 const auto &diff2 = p3 - p2;
                 const auto &normal2 = QVector2D(-diff2.y(), diff2.x()).normalized();
@@ -400,24 +547,19 @@ void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
                     const float sPhi = sin(phi);
                     const float rotation[4] = { cPhi, -sPhi, sPhi, cPhi };
 
-                    QVector<QVector2D> capVertices;
-                    capVertices.reserve(3 * m_segmentCount);
-
                     const auto centerPoint = p2;
 
                     for (int i = 0; i < m_segmentCount; ++i) {
-                        capVertices.append(centerPoint + currentOffset);
-                        capVertices.append(centerPoint);
+                        vertices.append(centerPoint + currentOffset);
+                        vertices.append(centerPoint);
 
                         const auto tmp = rotation[0] * currentOffset[0] + rotation[1] * currentOffset[1];
                         currentOffset[1] = rotation[2] * currentOffset[0] + rotation[3] * currentOffset[1];
                         currentOffset[0] = tmp;
 
-                        capVertices.append(centerPoint + currentOffset);
+                        vertices.append(centerPoint + currentOffset);
                     }
 
-                    lineDataSegment = lineDataSegment + capVertices;
-
                     break;
                 }
                 case Qt::PenJoinStyle::MiterJoin: {
@@ -426,16 +568,16 @@ void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
                             // calculate the intersection of the offset from p1 and p2
                             if (const auto pM = calculateIntersection(p1 - offset, p2 - offset, p3 - offset2, p2 - offset2);
                                 pM.has_value()) {
-                                lineDataSegment.append(p1 - offset);
-                                lineDataSegment.append(pM.value());
-                                lineDataSegment.append(p2 - offset2);
+                                vertices.append(p1 - offset);
+                                vertices.append(pM.value());
+                                vertices.append(p2 - offset2);
                             }
                         } else {
                             if (const auto pM = calculateIntersection(p1 + offset, p2 + offset, p3 + offset2, p2 + offset2);
                                 pM.has_value()) {
-                                lineDataSegment.append(p1 + offset);
-                                lineDataSegment.append(pM.value());
-                                lineDataSegment.append(p2 + offset2);
+                                vertices.append(p1 + offset);
+                                vertices.append(pM.value());
+                                vertices.append(p2 + offset2);
                             }
                         }
                     }
@@ -443,21 +585,73 @@ void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
                 }
                 case Qt::PenJoinStyle::BevelJoin:
                     if (turnLeft) {
-                        lineDataSegment.append(p1 - offset);
-                        lineDataSegment.append(p2);
-                        lineDataSegment.append(p2 - offset2);
+                        vertices.append(p1 - offset);
+                        vertices.append(p2);
+                        vertices.append(p2 - offset2);
                     } else {
-                        lineDataSegment.append(p1 + offset);
-                        lineDataSegment.append(p2);
-                        lineDataSegment.append(p2 + offset2);
+                        vertices.append(p1 + offset);
+                        vertices.append(p2);
+                        vertices.append(p2 + offset2);
                     }
                     break;
                 }
             }
         }
+    }
+}
+
+void RiveQtPath::updateStrokeCenterline()
+{
+    m_strokeCenterline.clear();
+    strokeScratch.joins.resize(0);
+    strokeScratch.caps.resize(0);
+
+    QVector<QVector2D> &segments = m_strokeCenterline.vertices;
+    m_strokeCenterline.beginSubPath();
+
+    for (int subPath = 0; subPath < m_outlineSubPaths.size(); ++subPath) {
+        const int firstPoint = m_outlineSubPaths.at(subPath);
+        const int pointCount =
+            (subPath + 1 < m_outlineSubPaths.size() ? m_outlineSubPaths.at(subPath + 1) : m_outlinePoints.size()) - firstPoint;
+        const PathDataPoint *pathData = m_outlinePoints.constData() + firstPoint;
+
+        const bool closed = pathData[0].point == pathData[pointCount - 1].point;
+        const int endIndex = collectOutlineSegments(pathData, pointCount, closed);
+
+        for (int i = 0; i < endIndex; ++i) {
+            segments.append(strokeScratch.starts.at(i));
+            segments.append(strokeScratch.ends.at(i));
+            segments.append(strokeScratch.normals.at(i));
+            segments.append(strokeScratch.endNormals.at(i));
+
+            if (const int next = joinedSegment(pathData, pointCount, closed, i); next >= 0) {
+                strokeScratch.joins.append(strokeScratch.ends.at(i));
+                strokeScratch.joins.append(strokeScratch.ends.at(i));
+                strokeScratch.joins.append(strokeScratch.endNormals.at(i));
+                strokeScratch.joins.append(strokeScratch.normals.at(next));
+            }
+        }
 
-        m_pathOutlineVertices.append(lineDataSegment);
+        if (!closed) {
+            // the outward direction is the normal turned by 90 degrees, backwards at the start and forwards at the end
+            const QVector2D &startNormal = strokeScratch.normals.first();
+            strokeScratch.caps.append(strokeScratch.starts.first());
+            strokeScratch.caps.append(strokeScratch.starts.first());
+            strokeScratch.caps.append(startNormal);
+            strokeScratch.caps.append(QVector2D(-startNormal.y(), startNormal.x()));
+
+            const QVector2D &endNormal = strokeScratch.endNormals.last();
+            strokeScratch.caps.append(strokeScratch.ends.last());
+            strokeScratch.caps.append(strokeScratch.ends.last());
+            strokeScratch.caps.append(endNormal);
+            strokeScratch.caps.append(QVector2D(endNormal.y(), -endNormal.x()));
+        }
     }
+
+    m_strokeCenterline.beginSubPath();
+    segments.append(strokeScratch.joins);
+    m_strokeCenterline.beginSubPath();
+    segments.append(strokeScratch.caps);
 }
 
 void RiveQtPath::updatePathSegmentsData()
@@ -469,9 +663,33 @@ void RiveQtPath::updatePathSegmentsData()
         return;
     }
 
+    if (m_fillMethod == RiveRenderSettings::Tessellator) {
+        fillTessellator.setTolerance(m_tolerance);
+        m_pathVertices.beginSubPath();
+        fillTessellator.tessellate(m_qPainterPath, m_pathVertices.vertices);
+        m_pathSegmentDataDirty = false;
+        return;
+    }
+
+    if (m_fillMethod == RiveRenderSettings::StencilAndCover) {
+        // first sub path is the fan drawn into the stencil buffer, second one the quad covering it
+        fillTessellator.setTolerance(m_tolerance);
+        m_pathVertices.beginSubPath();
+        if (fillTessellator.stencilFan(m_qPainterPath, m_pathVertices.vertices, coverScratch) > 0) {
+            m_pathVertices.beginSubPath();
+            m_pathVertices.vertices.append(coverScratch);
+        } else {
+            m_pathVertices.clear();
+        }
+        coverScratch.resize(0);
+        m_pathSegmentDataDirty = false;
+        return;
+    }
+
     QTriangleSet triangles = qTriangulate(m_qPainterPath);
 
-    QVector<QVector2D> pathData;
+    m_pathVertices.beginSubPath();
+    QVector<QVector2D> &pathData = m_pathVertices.vertices;
     pathData.reserve(triangles.indices.size());
     int index;
     for (int i = 0; i < triangles.indices.size(); i++) {
@@ -487,6 +705,5 @@ void RiveQtPath::updatePathSegmentsData()
         pathData.append(QVector2D(x, y));
     }
 
-    m_pathVertices.append(pathData);
     m_pathSegmentDataDirty = false;
 }
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <array>
+
 #include <QPainterPath>
 #include <QMatrix4x4>
 #include <QPen>
@@ -12,18 +14,69 @@
 #include <rive/renderer.hpp>
 #include <rive/math/raw_path.hpp>
 
+#include "datatypes.h"
+
+// Vertices of a path in one contiguous block, all sub paths one after another.
+// Renderers upload vertices as a whole, subPaths tells where every sub path starts.
+struct RiveQtPathGeometry
+{
+    bool isEmpty() const { return vertices.isEmpty(); }
+    int vertexCount() const { return vertices.size(); }
+
+    int subPathCount() const { return subPaths.size(); }
+    int subPathSize(int index) const
+    {
+        return (index + 1 < subPaths.size() ? subPaths.at(index + 1) : vertices.size()) - subPaths.at(index);
+    }
+    const QVector2D *subPathData(int index) const { return vertices.constData() + subPaths.at(index); }
+
+    // starts a new sub path at the current end of vertices
+    void beginSubPath() { subPaths.append(vertices.size()); }
+    // keeps the memory, so rebuilding the geometry of an animated path does not allocate
+    void clear()
+    {
+        vertices.resize(0);
+        subPaths.resize(0);
+    }
+
+    QVector<QVector2D> vertices;
+    QVector<int> subPaths; // index of the first vertex of every sub path
+};
+
 class RiveQtPath : public rive::RenderPath
 {
 public:
+    struct StrokeCacheStatistics
+    {
+        quint64 hits { 0 }; // strokes taken from the cache of their path
+        quint64 misses { 0 }; // strokes that needed to be extruded
+    };
+
     RiveQtPath(const unsigned segmentCount);
     RiveQtPath(const RiveQtPath &other);
     RiveQtPath(const rive::RawPath &rawPath, rive::FillRule fillRule, const unsigned segmentCount);
 
     void rewind() override;
-    void moveTo(float x, float y) override { m_qPainterPath.moveTo(x, y); }
-    void lineTo(float x, float y) override { m_qPainterPath.lineTo(x, y); }
-    void cubicTo(float ox, float oy, float ix, float iy, float x, float y) override { m_qPainterPath.cubicTo(ox, oy, ix, iy, x, y); }
-    void close() override { m_qPainterPath.closeSubpath(); }
+    void moveTo(float x, float y) override
+    {
+        m_qPainterPath.moveTo(x, y);
+        markDirty();
+    }
+    void lineTo(float x, float y) override
+    {
+        m_qPainterPath.lineTo(x, y);
+        markDirty();
+    }
+    void cubicTo(float ox, float oy, float ix, float iy, float x, float y) override
+    {
+        m_qPainterPath.cubicTo(ox, oy, ix, iy, x, y);
+        markDirty();
+    }
+    void close() override
+    {
+        m_qPainterPath.closeSubpath();
+        markDirty();
+    }
     void fillRule(rive::FillRule value) override;
     void addRenderPath(rive::RenderPath *path, const rive::Mat2D &transform) override;
 
@@ -32,11 +85,36 @@ public:
     QPainterPath toQPainterPaths(const QMatrix4x4 &t);
 
     void setSegmentCount(const unsigned segmentCount);
+    // maximum distance of flattened curves to the real curves in pixels
+    void setPixelTolerance(const float pixelTolerance);
+    // pixels per path unit of the current transform, curves get flattened finer the larger the path is drawn
+    void setDeviceScale(const float deviceScale);
+    // the tolerance in path units setDeviceScale ends up with
+    float toleranceForDeviceScale(const float deviceScale) const;
+    void setFillMethod(const RiveRenderSettings::FillMethod fillMethod);
+
+    // The returned geometry is valid until the path changes. Copies share the data, the path can only
+    // reuse the memory for the next geometry once they are released again.
+    const RiveQtPathGeometry &toVertices();
+    // Strokes are cached per pen, a path stroked by a few paints does not extrude them again every time.
+    // strokeGeneration comes from the paint, see RiveQtPaint::strokeGeneration.
+    const RiveQtPathGeometry &toVerticesLine(const QPen &pen, quint64 strokeGeneration);
+    // Centerline of the stroke, independent of the pen, to be expanded on the gpu.
+    // Four vectors per instance (start, end, start normal, end normal) in three sub paths: segments, joins and caps.
+    // Joins and caps only use the start, caps store their outward direction as end normal.
+    const RiveQtPathGeometry &toStrokeCenterline();
+
+    // unique for the lifetime of the process, used to identify the path in caches
+    quint64 id() const { return m_id; }
+    // changes every time the geometry of the path changes, caches built from an older generation are outdated
+    quint64 generation() const { return m_generation; }
 
-    QVector<QVector<QVector2D>> toVertices();
-    QVector<QVector<QVector2D>> toVerticesLine(const QPen &pen);
+    // counted over all paths
+    static StrokeCacheStatistics strokeCacheStatistics();
 
 private:
+    void markDirty();
+
     struct PathDataPoint
     {
         QVector2D point;
@@ -44,20 +122,45 @@ private:
         int stepIndex;
     };
 
-    static QPointF cubicBezier(const QPointF &startPoint, const QPointF &controlPoint1, const QPointF &controlPoint2,
-                               const QPointF &endPoint, qreal t);
-
     void updatePathSegmentsData();
     void updatePathSegmentsOutlineData();
-    void updatePathOutlineVertices(const QPen &pen);
+    void updatePathOutlineVertices(const QPen &pen, RiveQtPathGeometry &geometry);
+    void updateStrokeCenterline();
+    // fills the stroke scratch with the segments of one outline sub path, returns their number
+    int collectOutlineSegments(const PathDataPoint *pathData, int pointCount, bool closed);
+    // segment the one at index is joined with, -1 in case they need no join
+    static int joinedSegment(const PathDataPoint *pathData, int pointCount, bool closed, int index);
 
     QPainterPath m_qPainterPath;
-    QVector<QVector<PathDataPoint>> m_pathSegmentsOutlineData;
+    QVector<PathDataPoint> m_outlinePoints; // flattened sub paths of the outline, one after another
+    QVector<int> m_outlineSubPaths; // index of the first point of every sub path in m_outlinePoints
+
+    struct StrokeCacheEntry
+    {
+        float width { 0.f };
+        Qt::PenJoinStyle join { Qt::BevelJoin };
+        Qt::PenCapStyle cap { Qt::FlatCap };
+        unsigned segmentCount { 0 };
+        quint64 strokeGeneration { 0 };
+        quint64 pathGeneration { 0 }; // outdated once the path changed
+        quint64 lastUsed { 0 }; // 0 for unused entries
+        RiveQtPathGeometry geometry;
+    };
 
-    QVector<QVector<QVector2D>> m_pathVertices;
-    QVector<QVector<QVector2D>> m_pathOutlineVertices;
+    RiveQtPathGeometry m_pathVertices;
+    // fixed size, the geometries returned stay where they are while other pens get cached
+    std::array<StrokeCacheEntry, 4> m_strokeCache;
+    quint64 m_strokeCacheUseCounter { 0 };
+    RiveQtPathGeometry m_strokeCenterline;
 
     bool m_pathSegmentDataDirty { true };
-    bool m_pathSegmentOutlineDataDirty { true };
+    bool m_outlinePointsDirty { true };
+    bool m_strokeCenterlineDirty { true };
     unsigned m_segmentCount { 10 };
+    float m_pixelTolerance { 0.5f };
+    float m_tolerance { 0.5f }; // in path coordinates
+    RiveRenderSettings::FillMethod m_fillMethod { RiveRenderSettings::Tessellator };
+
+    quint64 m_id { 0 };
+    quint64 m_generation { 0 };
 };
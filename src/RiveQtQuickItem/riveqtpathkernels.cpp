@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define RQQP_KERNELS_SSE2
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define RQQP_KERNELS_NEON
+#    include <arm_neon.h>
+#endif
+
+#include "riveqtpathkernels.h"
+
+namespace {
+// four float lanes, the kernels below are written against these functions only
+#if defined(RQQP_KERNELS_SSE2)
+using Float4 = __m128;
+
+inline Float4 splat(float value) { return _mm_set1_ps(value); }
+inline Float4 load(const float *data) { return _mm_loadu_ps(data); }
+inline void store(float *data, Float4 value) { _mm_storeu_ps(data, value); }
+inline void storeLow(float *data, Float4 value) { _mm_storel_pi(reinterpret_cast<__m64 *>(data), value); }
+inline void storeHigh(float *data, Float4 value) { _mm_storeh_pi(reinterpret_cast<__m64 *>(data), value); }
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a); }
+// a / b, 0 where b is 0
+inline Float4 divOrZero(Float4 a, Float4 b) { return _mm_and_ps(_mm_cmpgt_ps(b, _mm_setzero_ps()), _mm_div_ps(a, b)); }
+// x0 y0 x1 y1 and x2 y2 x3 y3 from x0 x1 x2 x3 and y0 y1 y2 y3
+inline Float4 interleaveLow(Float4 x, Float4 y) { return _mm_unpacklo_ps(x, y); }
+inline Float4 interleaveHigh(Float4 x, Float4 y) { return _mm_unpackhi_ps(x, y); }
+#elif defined(RQQP_KERNELS_NEON)
+using Float4 = float32x4_t;
+
+inline Float4 splat(float value) { return vdupq_n_f32(value); }
+inline Float4 load(const float *data) { return vld1q_f32(data); }
+inline void store(float *data, Float4 value) { vst1q_f32(data, value); }
+inline void storeLow(float *data, Float4 value) { vst1_f32(data, vget_low_f32(value)); }
+inline void storeHigh(float *data, Float4 value) { vst1_f32(data, vget_high_f32(value)); }
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 div(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+inline Float4 sqrt(Float4 a) { return vsqrtq_f32(a); }
+inline Float4 divOrZero(Float4 a, Float4 b) { return vbslq_f32(vcgtq_f32(b, vdupq_n_f32(0.f)), vdivq_f32(a, b), vdupq_n_f32(0.f)); }
+inline Float4 interleaveLow(Float4 x, Float4 y) { return vzip1q_f32(x, y); }
+inline Float4 interleaveHigh(Float4 x, Float4 y) { return vzip2q_f32(x, y); }
+#else
+struct Float4
+{
+    float v[4];
+};
+
+template<typename Operation>
+inline Float4 apply(Float4 a, Float4 b, Operation operation)
+{
+    return { { operation(a.v[0], b.v[0]), operation(a.v[1], b.v[1]), operation(a.v[2], b.v[2]), operation(a.v[3], b.v[3]) } };
+}
+
+inline Float4 splat(float value) { return { { value, value, value, value } }; }
+inline Float4 load(const float *data) { return { { data[0], data[1], data[2], data[3] } }; }
+inline void store(float *data, Float4 value) { std::memcpy(data, value.v, sizeof(value.v)); }
+inline void storeLow(float *data, Float4 value) { std::memcpy(data, value.v, 2 * sizeof(float)); }
+inline void storeHigh(float *data, Float4 value) { std::memcpy(data, value.v + 2, 2 * sizeof(float)); }
+inline Float4 add(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+inline Float4 sub(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+inline Float4 mul(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+inline Float4 div(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+inline Float4 sqrt(Float4 a) { return { { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+inline Float4 divOrZero(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return y > 0.f ? x / y : 0.f; }); }
+inline Float4 interleaveLow(Float4 x, Float4 y) { return { { x.v[0], y.v[0], x.v[1], y.v[1] } }; }
+inline Float4 interleaveHigh(Float4 x, Float4 y) { return { { x.v[2], y.v[2], x.v[3], y.v[3] } }; }
+#endif
+}
+
+void RiveQtPathKernels::evaluateCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3,
+                                      int segmentCount, float *positions, float *tangents)
+{
+    if (segmentCount <= 0) {
+        return;
+    }
+
+    const Float4 x0 = splat(p0.x());
+    const Float4 y0 = splat(p0.y());
+    const Float4 x1 = splat(p1.x());
+    const Float4 y1 = splat(p1.y());
+    const Float4 x2 = splat(p2.x());
+    const Float4 y2 = splat(p2.y());
+    const Float4 x3 = splat(p3.x());
+    const Float4 y3 = splat(p3.y());
+
+    // differences of the control points, the derivative is a quadratic bezier of them
+    const Float4 dx0 = sub(x1, x0);
+    const Float4 dy0 = sub(y1, y0);
+    const Float4 dx1 = sub(x2, x1);
+    const Float4 dy1 = sub(y2, y1);
+    const Float4 dx2 = sub(x3, x2);
+    const Float4 dy2 = sub(y3, y2);
+
+    const float laneOffsets[4] = { 1.f, 2.f, 3.f, 4.f };
+    const Float4 lanes = load(laneOffsets);
+    const Float4 count = splat(float(segmentCount));
+    const Float4 one = splat(1.f);
+    const Float4 two = splat(2.f);
+    const Float4 three = splat(3.f);
+
+    for (int i = 0; i < segmentCount; i += 4) {
+        // dividing instead of multiplying with the inverse keeps the last point exactly at t = 1
+        const Float4 t = div(add(splat(float(i)), lanes), count);
+        const Float4 mt = sub(one, t);
+        const Float4 mt2 = mul(mt, mt);
+        const Float4 t2 = mul(t, t);
+
+        const Float4 b0 = mul(mt2, mt);
+        const Float4 b1 = mul(three, mul(mt2, t));
+        const Float4 b2 = mul(three, mul(mt, t2));
+        const Float4 b3 = mul(t2, t);
+
+        const Float4 x = add(add(mul(b0, x0), mul(b1, x1)), add(mul(b2, x2), mul(b3, x3)));
+        const Float4 y = add(add(mul(b0, y0), mul(b1, y1)), add(mul(b2, y2), mul(b3, y3)));
+
+        const Float4 mtt2 = mul(two, mul(mt, t));
+        const Float4 dx = add(add(mul(mt2, dx0), mul(mtt2, dx1)), mul(t2, dx2));
+        const Float4 dy = add(add(mul(mt2, dy0), mul(mtt2, dy1)), mul(t2, dy2));
+        const Float4 length = sqrt(add(mul(dx, dx), mul(dy, dy)));
+        const Float4 tx = divOrZero(dx, length);
+        const Float4 ty = divOrZero(dy, length);
+
+        if (i + 4 <= segmentCount) {
+            store(positions + 2 * i, interleaveLow(x, y));
+            store(positions + 2 * i + 4, interleaveHigh(x, y));
+            store(tangents + 2 * i, interleaveLow(tx, ty));
+            store(tangents + 2 * i + 4, interleaveHigh(tx, ty));
+        } else {
+            // the last block is only partially used
+            float positionBlock[8];
+            float tangentBlock[8];
+            store(positionBlock, interleaveLow(x, y));
+            store(positionBlock + 4, interleaveHigh(x, y));
+            store(tangentBlock, interleaveLow(tx, ty));
+            store(tangentBlock + 4, interleaveHigh(tx, ty));
+
+            const size_t bytes = 2 * (segmentCount - i) * sizeof(float);
+            std::memcpy(positions + 2 * i, positionBlock, bytes);
+            std::memcpy(tangents + 2 * i, tangentBlock, bytes);
+        }
+    }
+}
+
+void RiveQtPathKernels::extrudeSegments(const float *starts, const float *ends, const float *startNormals, const float *endNormals,
+                                        int count, float halfWidth, float *vertices)
+{
+    const Float4 width = splat(halfWidth);
+
+    // two segments per iteration, each lane pair holds one x/y
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const Float4 start = load(starts + 2 * i);
+        const Float4 end = load(ends + 2 * i);
+        const Float4 offset = mul(load(startNormals + 2 * i), width);
+        const Float4 endOffset = mul(load(endNormals + 2 * i), width);
+
+        const Float4 startPlus = add(start, offset);
+        const Float4 startMinus = sub(start, offset);
+        const Float4 endPlus = add(end, endOffset);
+        const Float4 endMinus = sub(end, endOffset);
+
+        float *first = vertices + 12 * i;
+        storeLow(first, startPlus);
+        storeLow(first + 2, startMinus);
+        storeLow(first + 4, endPlus);
+        storeLow(first + 6, endPlus);
+        storeLow(first + 8, endMinus);
+        storeLow(first + 10, startMinus);
+
+        float *second = first + 12;
+        storeHigh(second, startPlus);
+        storeHigh(second + 2, startMinus);
+        storeHigh(second + 4, endPlus);
+        storeHigh(second + 6, endPlus);
+        storeHigh(second + 8, endMinus);
+        storeHigh(second + 10, startMinus);
+    }
+
+    if (i < count) {
+        const float offsetX = startNormals[2 * i] * halfWidth;
+        const float offsetY = startNormals[2 * i + 1] * halfWidth;
+        const float endOffsetX = endNormals[2 * i] * halfWidth;
+        const float endOffsetY = endNormals[2 * i + 1] * halfWidth;
+
+        const float startX = starts[2 * i];
+        const float startY = starts[2 * i + 1];
+        const float endX = ends[2 * i];
+        const float endY = ends[2 * i + 1];
+
+        const float quad[12] = { startX + offsetX,  startY + offsetY,  startX - offsetX,  startY - offsetY,
+                                 endX + endOffsetX, endY + endOffsetY, endX + endOffsetX, endY + endOffsetY,
+                                 endX - endOffsetX, endY - endOffsetY, startX - offsetX,  startY - offsetY };
+        std::memcpy(vertices + 12 * i, quad, sizeof(quad));
+    }
+}
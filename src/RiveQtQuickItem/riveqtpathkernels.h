@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QVector2D>
+
+// Batched geometry kernels used to flatten and stroke paths.
+//
+// They work on flat float arrays of interleaved x/y pairs and process four values at once,
+// using SSE2 on x86, NEON on 64 bit arm and plain scalar code everywhere else.
+namespace RiveQtPathKernels {
+// Evaluates the cubic bezier at t = i / segmentCount for i = 1 .. segmentCount.
+// Writes segmentCount points to positions and segmentCount normalized tangents to tangents (2 floats each).
+void evaluateCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segmentCount, float *positions,
+                   float *tangents);
+
+// Extrudes count line segments from starts to ends by halfWidth along their normals.
+// Writes the two triangles of each segment's quad to vertices (12 floats per segment), in the order
+// start + offset, start - offset, end + endOffset, end + endOffset, end - endOffset, start - offset.
+void extrudeSegments(const float *starts, const float *ends, const float *startNormals, const float *endNormals, int count,
+                     float halfWidth, float *vertices);
+}
@@ -4,11 +4,12 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <QMetaMethod>
 #include <QSGRendererInterface>
 #include <QSGRenderNode>
 #include <QQmlEngine>
 #include <QQuickWindow>
-#include <QFile>
+#include <QtConcurrent>
 
 #include <rive/node.hpp>
 #include <rive/shapes/clipping_shape.hpp>
@@ -20,11 +21,39 @@
 #include <rive/generated/shapes/shape_base.hpp>
 #include <rive/animation/state_machine_listener.hpp>
 #include <rive/file.hpp>
+#include <rive/component.hpp>
+#include <rive/component_dirt.hpp>
 
 #include "rive/animation/state_machine_input_instance.hpp"
 #include "rqqplogging.h"
 #include "riveqtquickitem.h"
+#include "riveqtfilecache.h"
 #include "renderer/riveqtfactory.h"
+#include "renderer/riveqtdisplaylist.h"
+#include "renderer/riveqtimage.h"
+
+namespace {
+// Components the runtime marked dirty, the next Artboard::advance updates exactly these.
+// Dirt is a bit field and only readable flag by flag, the lowest bit (collapsed) is no reason for an update.
+int dirtyComponentCount(const rive::ArtboardInstance *artboardInstance)
+{
+    int count = 0;
+    for (rive::Core *object : artboardInstance->objects()) {
+        if (!object || !object->is<rive::Component>()) {
+            continue;
+        }
+
+        const rive::Component *component = object->as<rive::Component>();
+        for (int bit = 1; bit < 16; ++bit) {
+            if (component->hasDirt(static_cast<rive::ComponentDirt>(1 << bit))) {
+                ++count;
+                break;
+            }
+        }
+    }
+    return count;
+}
+}
 
 RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
     : QQuickItem(parent)
@@ -35,6 +64,9 @@ RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
     setAcceptedMouseButtons(Qt::AllButtons);
     setAcceptHoverEvents(true);
 
+    // an image skipped while it was decoding only shows up with another frame, even if we went idle meanwhile
+    m_decodeListener = std::make_shared<RiveQtDecodeListener>(this, [this]() { wakeUp(); });
+
     // we require a window to know the render backend and setup the correct.
     connect(this, &RiveQtQuickItem::windowChanged, this, [this]() { loadRiveFile(m_fileSource); });
 
@@ -64,10 +96,20 @@ RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
     m_elapsedTimer.start();
     m_lastUpdateTime = m_elapsedTimer.elapsed();
 
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, [this]() { update(); });
+
     update();
 }
 
-RiveQtQuickItem::~RiveQtQuickItem() { }
+RiveQtQuickItem::~RiveQtQuickItem()
+{
+    // Pending imports post their result back to us, make sure they are done before we are gone.
+    // An import can not be interrupted, this blocks until the running ones finished, superseded ones included.
+    m_loadingFutures.waitForFinished();
+    m_decodeListener->detach();
+}
 
 void RiveQtQuickItem::triggerAnimation(int id)
 {
@@ -93,6 +135,7 @@ void RiveQtQuickItem::triggerAnimation(int id)
 
     qCDebug(rqqpItem) << "Selected Animation" << QString::fromStdString(m_animationInstance->name());
     emit currentAnimationIndexChanged();
+    wakeUp();
 }
 
 void RiveQtQuickItem::updateStateMachineInputMap()
@@ -101,6 +144,7 @@ void RiveQtQuickItem::updateStateMachineInputMap()
     // well what could go wrong. aka TODO: dont do this
     m_stateMachineInputMap->deleteLater();
     m_stateMachineInputMap = new RiveQtStateMachineInputMap(m_currentStateMachineInstance, this);
+    connect(m_stateMachineInputMap, &RiveQtStateMachineInputMap::inputChanged, this, &RiveQtQuickItem::wakeUp);
     emit stateMachineInterfaceChanged();
 }
 
@@ -165,6 +209,7 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
 
         // reset all
         m_riveFile = nullptr;
+        m_hasRecordedFrame = false;
         m_scheduleArtboardChange = true;
         m_scheduleStateMachineChange = true;
 
@@ -182,6 +227,8 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
     }
 
     if (m_scheduleArtboardChange) {
+        // recorded from the previous artboard
+        m_hasRecordedFrame = false;
         updateInternalArtboard();
 
         if (m_renderNode) {
@@ -221,26 +268,37 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
         m_renderNode = m_riveQtFactory.renderNode(currentWindow, m_currentArtboardInstance, this->boundingRect());
     }
 
-    qint64 currentTime = m_elapsedTimer.elapsed();
-    float deltaTime = (currentTime - m_lastUpdateTime) / 1000.0f;
-    m_lastUpdateTime = currentTime;
+    // in between the due frames the node keeps showing the last one
+    const bool isSyncFrameDue = m_renderSettings.advanceMode == RiveRenderSettings::AdvanceDuringSync && isFrameDue();
+    if (isSyncFrameDue) {
+        advanceArtboard();
+    }
 
-    if (m_currentArtboardInstance) {
-        if (m_animationInstance) {
-            bool shouldContinue = m_animationInstance->advance(deltaTime);
-            if (shouldContinue) {
-                m_animationInstance->apply();
+    if (m_renderNode) {
+        // can be switched at runtime, the paths tessellate again the next time they get drawn
+        m_renderNode->setFillMethod(m_renderSettings.fillMethod);
+        m_renderNode->setRenderScale(m_renderSettings.renderScale);
+        m_renderNode->setDecodeListener(m_decodeListener);
+
+        if (m_renderSettings.advanceMode == RiveRenderSettings::AdvanceOnGuiThread) {
+            // A new node or artboard has no frame handed over yet. The node must not record it on the render thread,
+            // recordFrame advances the artboard on the gui thread meanwhile, so record it now while both are blocked.
+            if (!m_hasRecordedFrame && m_renderNode->recordsArtboard() && m_currentArtboardInstance) {
+                recordDisplayList();
+            }
+
+            // the frame got recorded before the sync already, only the display lists change hands
+            if (m_hasRecordedFrame) {
+                m_renderNode->swapDisplayList(m_recordedDisplayList);
+                m_hasRecordedFrame = false;
+            }
+        } else {
+            m_renderNode->setRecordsArtboard(true);
+            if (isSyncFrameDue) {
+                m_renderNode->markFrameDue();
             }
         }
-        if (m_currentStateMachineInstance) {
-            m_currentStateMachineInstance->advance(deltaTime);
-        }
-        m_currentArtboardInstance->updateComponents();
-        m_currentArtboardInstance->advance(deltaTime);
-        m_currentArtboardInstance->update(rive::ComponentDirt::Filthy);
-    }
 
-    if (m_renderNode) {
         m_renderNode->markDirty(QSGNode::DirtyForceUpdate);
     }
 
@@ -253,7 +311,10 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
     }
 #endif
 
-    this->update();
+    // once nothing plays anymore the item stays on its last frame until something wakes it up again
+    if (!m_isIdle) {
+        scheduleNextFrame();
+    }
 
     if (et.isValid()) {
         m_frameRate = int(1000000000 / et.nsecsElapsed());
@@ -265,12 +326,128 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
     return m_renderNode;
 }
 
+void RiveQtQuickItem::advanceArtboard()
+{
+    qint64 currentTime = m_elapsedTimer.elapsed();
+    float deltaTime = (currentTime - m_lastUpdateTime) / 1000.0f;
+    m_lastUpdateTime = currentTime;
+
+    if (!m_currentArtboardInstance) {
+        return;
+    }
+
+    bool isPlaying = false;
+    if (m_animationInstance) {
+        // false once an animation without loop reached its end
+        bool shouldContinue = m_animationInstance->advance(deltaTime);
+        if (shouldContinue) {
+            m_animationInstance->apply();
+        }
+        isPlaying = shouldContinue;
+    }
+    if (m_currentStateMachineInstance) {
+        isPlaying |= m_currentStateMachineInstance->advance(deltaTime);
+    }
+
+    // Only what animations, state machine and input marked dirty gets updated, static parts of the artboard are left alone.
+    // Counting them walks all objects of the artboard, so that is only done while someone observes the count.
+    static const QMetaMethod updatedComponentCountSignal = QMetaMethod::fromSignal(&RiveQtQuickItem::updatedComponentCountChanged);
+    const bool countsComponents = isSignalConnected(updatedComponentCountSignal);
+    const int updatedComponentCount = countsComponents ? dirtyComponentCount(m_currentArtboardInstance.get()) : 0;
+    const bool hasChanged = m_currentArtboardInstance->advance(deltaTime);
+
+    m_isIdle = !isPlaying && !hasChanged;
+
+    if (countsComponents && m_updatedComponentCount != updatedComponentCount) {
+        m_updatedComponentCount = updatedComponentCount;
+        emit updatedComponentCountChanged();
+    }
+}
+
+void RiveQtQuickItem::wakeUp()
+{
+    if (m_isIdle) {
+        // the time spent idle is no part of the animation, the next frame is due right away
+        m_lastUpdateTime = m_elapsedTimer.elapsed() - frameInterval();
+        m_isIdle = false;
+    }
+
+    update();
+}
+
+int RiveQtQuickItem::frameInterval() const
+{
+    int frameRate = m_maxFrameRate;
+
+    // state machines blend several animations, there is no single authored rate to lock to
+    if (m_lockToAnimationFps && m_animationInstance && !m_currentStateMachineInstance) {
+        const int animationFps = static_cast<int>(m_animationInstance->animation()->fps());
+        if (animationFps > 0 && (frameRate <= 0 || animationFps < frameRate)) {
+            frameRate = animationFps;
+        }
+    }
+
+    return frameRate > 0 ? 1000 / frameRate : 0;
+}
+
+bool RiveQtQuickItem::isFrameDue() const
+{
+    // frames of the window come with some jitter, a frame arriving slightly early still counts
+    constexpr qint64 frameSlack = 2;
+    return m_elapsedTimer.elapsed() - m_lastUpdateTime + frameSlack >= frameInterval();
+}
+
+void RiveQtQuickItem::scheduleNextFrame()
+{
+    const int interval = frameInterval();
+    if (interval == 0) {
+        update();
+        return;
+    }
+
+    // no frames of the window are requested until the next animation frame is due
+    const int delay = qMax(0, int(m_lastUpdateTime + interval - m_elapsedTimer.elapsed()));
+    QMetaObject::invokeMethod(
+        this, [this, delay]() { m_frameTimer.start(delay); }, Qt::QueuedConnection);
+}
+
+void RiveQtQuickItem::recordFrame()
+{
+    // afterAnimating comes for every frame of the window, also the ones other items asked for
+    if (m_renderSettings.advanceMode != RiveRenderSettings::AdvanceOnGuiThread || m_isIdle || !isFrameDue()) {
+        return;
+    }
+
+    // artboard and file only change during the sync, while we are blocked
+    if (m_loadingStatus != Loaded || !m_currentArtboardInstance || !m_hasValidRenderNode || !isVisible()) {
+        return;
+    }
+
+    advanceArtboard();
+
+    // the render thread meanwhile replays the list handed over in the last sync
+    recordDisplayList();
+}
+
+void RiveQtQuickItem::recordDisplayList()
+{
+    if (!m_recordedDisplayList) {
+        m_recordedDisplayList = m_riveQtFactory.makeDisplayList();
+    }
+
+    m_recordedDisplayList->setDecodeListener(m_decodeListener);
+    m_recordedDisplayList->beginRecording();
+    m_currentArtboardInstance->draw(m_recordedDisplayList.get());
+    m_recordedDisplayList->endRecording();
+    m_hasRecordedFrame = true;
+}
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 void RiveQtQuickItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
 {
     m_geometryChanged = true;
 
-    update();
+    wakeUp();
     QQuickItem::geometryChange(newGeometry, oldGeometry);
     qDebug() << "GEOMETRY geometryChange";
 }
@@ -279,7 +456,7 @@ void RiveQtQuickItem::geometryChanged(const QRectF &newGeometry, const QRectF &o
 {
     m_geometryChanged = true;
 
-    update();
+    wakeUp();
     QQuickItem::geometryChanged(newGeometry, oldGeometry);
 }
 #endif
@@ -353,6 +530,9 @@ int RiveQtQuickItem::currentAnimationIndex() const
 
 void RiveQtQuickItem::loadRiveFile(const QString &source)
 {
+    // whatever happens below, results of loads started before are outdated now
+    const quint64 loadRequest = ++m_loadRequest;
+
     if (m_loadingStatus != Idle && m_loadingStatus != Unloading && m_loadingStatus != Loading) {
         // clear the data
         m_artboardInfoList.clear();
@@ -393,33 +573,69 @@ void RiveQtQuickItem::loadRiveFile(const QString &source)
     connect(currentWindow, &QQuickWindow::beforeFrameBegin, this, &RiveQtQuickItem::renderOffscreen,
             static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection));
 #endif
+    // emitted on the gui thread right before the sync
+    connect(currentWindow, &QQuickWindow::afterAnimating, this, &RiveQtQuickItem::recordFrame, Qt::UniqueConnection);
 
-    QFile file(source);
+    // the factory used for importing decides which kind of paths get created, so it needs to know the backend beforehand
+    m_renderSettings.graphicsApi = currentWindow->rendererInterface()->graphicsApi();
+    m_riveQtFactory.setRenderSettings(m_renderSettings);
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCWarning(rqqpItem) << "Failed to open the file " << source;
-        m_loadingStatus = Error;
-        emit loadingStatusChanged();
+    setLoadingProgress(0.0);
+
+    if (!m_asynchronous) {
+        rive::ImportResult importResult;
+        auto riveFile = RiveQtFileCache::instance()->acquire(source, m_renderSettings, &importResult);
+        finishLoading(loadRequest, riveFile, importResult);
         return;
     }
 
-    QByteArray fileData = file.readAll();
-    file.close();
+    // only loads still running have to be waited for, the finished ones would pile up with every source change
+    const QList<QFuture<void>> loadingFutures = m_loadingFutures.futures();
+    m_loadingFutures.clearFutures();
+    for (const QFuture<void> &future : loadingFutures) {
+        if (!future.isFinished()) {
+            m_loadingFutures.addFuture(future);
+        }
+    }
 
-    rive::Span<const uint8_t> dataSpan(reinterpret_cast<const uint8_t *>(fileData.constData()), fileData.size());
+    // read, import and decoding of embedded assets run on the thread pool, we stay in Loading until the result is handed back
+    const RiveRenderSettings renderSettings = m_renderSettings;
+    m_loadingFutures.addFuture(QtConcurrent::run([this, source, renderSettings, loadRequest]() {
+        const auto reportProgress = [this, loadRequest](qreal progress) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, loadRequest, progress]() {
+                    if (loadRequest == m_loadRequest) {
+                        setLoadingProgress(progress);
+                    }
+                },
+                Qt::QueuedConnection);
+        };
+
+        rive::ImportResult importResult;
+        auto riveFile = RiveQtFileCache::instance()->acquire(source, renderSettings, &importResult, reportProgress);
+
+        QMetaObject::invokeMethod(
+            this, [this, loadRequest, riveFile, importResult]() { finishLoading(loadRequest, riveFile, importResult); },
+            Qt::QueuedConnection);
+    }));
+}
 
-    rive::ImportResult importResult;
-    m_riveFile = rive::File::import(dataSpan, &m_riveQtFactory, &importResult);
+void RiveQtQuickItem::finishLoading(quint64 loadRequest, std::shared_ptr<rive::File> riveFile, rive::ImportResult importResult)
+{
+    if (loadRequest != m_loadRequest || m_loadingStatus != Loading) {
+        qCDebug(rqqpItem) << "Dropping result of superseded load request" << loadRequest;
+        return;
+    }
 
-    if (importResult != rive::ImportResult::success) {
+    if (!riveFile || importResult != rive::ImportResult::success) {
         qCDebug(rqqpItem) << "Failed to import Rive file.";
         m_loadingStatus = Error;
         emit loadingStatusChanged();
         return;
     }
 
-    m_renderSettings.graphicsApi = currentWindow->rendererInterface()->graphicsApi();
-    m_riveQtFactory.setRenderSettings(m_renderSettings);
+    m_riveFile = riveFile;
 
     // Update artboard info
     m_artboardInfoList.clear();
@@ -443,8 +659,31 @@ void RiveQtQuickItem::loadRiveFile(const QString &source)
     m_scheduleStateMachineChange = true;
 
     qCDebug(rqqpItem) << "Successfully imported Rive file.";
+    setLoadingProgress(1.0);
     m_loadingStatus = Loaded;
     emit loadingStatusChanged();
+
+    wakeUp();
+}
+
+void RiveQtQuickItem::setLoadingProgress(qreal progress)
+{
+    if (qFuzzyCompare(m_loadingProgress, progress)) {
+        return;
+    }
+
+    m_loadingProgress = progress;
+    emit loadingProgressChanged();
+}
+
+void RiveQtQuickItem::setAsynchronous(bool asynchronous)
+{
+    if (m_asynchronous == asynchronous) {
+        return;
+    }
+
+    m_asynchronous = asynchronous;
+    emit asynchronousChanged();
 }
 
 void RiveQtQuickItem::updateAnimations()
@@ -529,6 +768,9 @@ bool RiveQtQuickItem::hitTest(const QPointF &pos, const rive::ListenerType &type
         return false;
     }
 
+    // listeners of the state machine might start to animate
+    wakeUp();
+
     // m_renderNode is managed and owend by the renderThread the calls should be ok (as they only read)
     // but still some potential to cause trouble
     m_lastMouseX = (pos.x() - m_renderNode->topLeft().rx()) / m_renderNode->scaleFactorX();
@@ -696,7 +938,7 @@ void RiveQtQuickItem::setCurrentArtboardIndex(const int newIndex)
 
     m_scheduleArtboardChange = true; // we have to do this in the render thread.
     m_renderNode = nullptr;
-    update();
+    wakeUp();
 }
 
 int RiveQtQuickItem::currentStateMachineIndex() const
@@ -727,7 +969,7 @@ void RiveQtQuickItem::setCurrentStateMachineIndex(const int newCurrentStateMachi
     m_scheduleStateMachineChange = true; // we have to do this in the render thread.
     // emit stateMachineInterfaceChanged();
 
-    update();
+    wakeUp();
 }
 
 RiveQtStateMachineInputMap *RiveQtQuickItem::stateMachineInterface() const
@@ -756,3 +998,38 @@ void RiveQtQuickItem::setInteractive(bool newInteractive)
 
     emit interactiveChanged();
 }
+
+void RiveQtQuickItem::setRenderScale(qreal renderScale)
+{
+    renderScale = qMax(0.0, renderScale);
+    if (m_renderSettings.renderScale == renderScale) {
+        return;
+    }
+
+    m_renderSettings.renderScale = renderScale;
+    emit renderScaleChanged();
+    wakeUp();
+}
+
+void RiveQtQuickItem::setMaxFrameRate(int maxFrameRate)
+{
+    maxFrameRate = qMax(0, maxFrameRate);
+    if (m_maxFrameRate == maxFrameRate) {
+        return;
+    }
+
+    m_maxFrameRate = maxFrameRate;
+    emit maxFrameRateChanged();
+    wakeUp();
+}
+
+void RiveQtQuickItem::setLockToAnimationFps(bool lockToAnimationFps)
+{
+    if (m_lockToAnimationFps == lockToAnimationFps) {
+        return;
+    }
+
+    m_lockToAnimationFps = lockToAnimationFps;
+    emit lockToAnimationFpsChanged();
+    wakeUp();
+}
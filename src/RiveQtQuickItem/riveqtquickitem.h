@@ -6,6 +6,7 @@
 #pragma once
 
 #include <QElapsedTimer>
+#include <QFutureSynchronizer>
 #include <QQuickItem>
 #include <QQuickPaintedItem>
 #include <QSGRenderNode>
@@ -29,6 +30,8 @@
 #endif
 
 class RiveQSGRenderNode;
+class RiveQtDecodeListener;
+class RiveQtDisplayList;
 class RiveQSGRHIRenderNode;
 
 class RiveQtQuickItem : public QQuickItem
@@ -37,6 +40,8 @@ class RiveQtQuickItem : public QQuickItem
 
     Q_PROPERTY(QString fileSource READ fileSource WRITE setFileSource NOTIFY fileSourceChanged)
     Q_PROPERTY(LoadingStatus loadingStatus READ loadingStatus NOTIFY loadingStatusChanged)
+    Q_PROPERTY(qreal loadingProgress READ loadingProgress NOTIFY loadingProgressChanged)
+    Q_PROPERTY(bool asynchronous READ asynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
     Q_PROPERTY(QVector<ArtBoardInfo> artboards READ artboards NOTIFY artboardsChanged)
     Q_PROPERTY(QVector<AnimationInfo> animations READ animations NOTIFY animationsChanged)
     Q_PROPERTY(QVector<StateMachineInfo> stateMachines READ stateMachines NOTIFY stateMachinesChanged)
@@ -52,8 +57,15 @@ class RiveQtQuickItem : public QQuickItem
 
     Q_PROPERTY(RiveRenderSettings::RenderQuality renderQuality READ renderQuality WRITE setRenderQuality NOTIFY renderQualityChanged)
     Q_PROPERTY(RiveRenderSettings::FillMode fillMode READ fillMode WRITE setFillMode NOTIFY fillModeChanged)
+    Q_PROPERTY(RiveRenderSettings::FillMethod fillMethod READ fillMethod WRITE setFillMethod NOTIFY fillMethodChanged)
+    Q_PROPERTY(RiveRenderSettings::AdvanceMode advanceMode READ advanceMode WRITE setAdvanceMode NOTIFY advanceModeChanged)
+    Q_PROPERTY(qreal renderScale READ renderScale WRITE setRenderScale NOTIFY renderScaleChanged)
+
+    Q_PROPERTY(int maxFrameRate READ maxFrameRate WRITE setMaxFrameRate NOTIFY maxFrameRateChanged)
+    Q_PROPERTY(bool lockToAnimationFps READ lockToAnimationFps WRITE setLockToAnimationFps NOTIFY lockToAnimationFpsChanged)
 
     Q_PROPERTY(int frameRate READ frameRate NOTIFY frameRateChanged)
+    Q_PROPERTY(int updatedComponentCount READ updatedComponentCount NOTIFY updatedComponentCountChanged)
 
     QML_ELEMENT
 
@@ -80,6 +92,10 @@ public:
     void setFileSource(const QString &source);
 
     LoadingStatus loadingStatus() const { return m_loadingStatus; }
+    qreal loadingProgress() const { return m_loadingProgress; }
+
+    bool asynchronous() const { return m_asynchronous; }
+    void setAsynchronous(bool asynchronous);
 
     int currentAnimationIndex() const;
     int currentArtboardIndex() const;
@@ -109,9 +125,40 @@ public:
     {
         m_renderSettings.fillMode = fillMode;
         emit fillModeChanged();
+        wakeUp();
+    }
+
+    RiveRenderSettings::FillMethod fillMethod() const { return m_renderSettings.fillMethod; }
+    void setFillMethod(const RiveRenderSettings::FillMethod fillMethod)
+    {
+        m_renderSettings.fillMethod = fillMethod;
+        emit fillMethodChanged();
+        wakeUp();
     }
 
+    RiveRenderSettings::AdvanceMode advanceMode() const { return m_renderSettings.advanceMode; }
+    void setAdvanceMode(const RiveRenderSettings::AdvanceMode advanceMode)
+    {
+        m_renderSettings.advanceMode = advanceMode;
+        emit advanceModeChanged();
+    }
+
+    // only used by the rhi renderer, which renders into a texture of its own
+    qreal renderScale() const { return m_renderSettings.renderScale; }
+    void setRenderScale(qreal renderScale);
+
+    // upper limit of artboard frames per second, 0 for as many as the window renders
+    int maxFrameRate() const { return m_maxFrameRate; }
+    void setMaxFrameRate(int maxFrameRate);
+
+    // advance the linear animation only as often as its authored fps, not used while a state machine runs
+    bool lockToAnimationFps() const { return m_lockToAnimationFps; }
+    void setLockToAnimationFps(bool lockToAnimationFps);
+
     int frameRate() { return m_frameRate; }
+    // Components of the artboard updated in the last frame, everything else was not marked dirty.
+    // Only counted while updatedComponentCountChanged is connected, e.g. by a binding.
+    int updatedComponentCount() const { return m_updatedComponentCount; }
 
 signals:
     void animationsChanged();
@@ -120,6 +167,8 @@ signals:
 
     void fileSourceChanged();
     void loadingStatusChanged();
+    void loadingProgressChanged();
+    void asynchronousChanged();
 
     void currentArtboardIndexChanged();
     void currentAnimationIndexChanged();
@@ -134,8 +183,15 @@ signals:
 
     void renderQualityChanged();
     void fillModeChanged();
+    void fillMethodChanged();
+    void advanceModeChanged();
+    void renderScaleChanged();
+
+    void maxFrameRateChanged();
+    void lockToAnimationFpsChanged();
 
     void frameRateChanged();
+    void updatedComponentCountChanged();
 
 protected:
     QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override;
@@ -158,6 +214,8 @@ private slots:
 
 private:
     void loadRiveFile(const QString &source);
+    void finishLoading(quint64 loadRequest, std::shared_ptr<rive::File> riveFile, rive::ImportResult importResult);
+    void setLoadingProgress(qreal progress);
 
     void updateInternalArtboard();
     void updateAnimations();
@@ -165,6 +223,18 @@ private:
     void updateCurrentArtboardIndex();
     void updateCurrentStateMachineIndex();
 
+    void advanceArtboard();
+    // schedules frames again after the item went idle
+    void wakeUp();
+    // milliseconds between two artboard frames, 0 in case every frame of the window is one
+    int frameInterval() const;
+    bool isFrameDue() const;
+    void scheduleNextFrame();
+    // advances and records the artboard on the gui thread, in AdvanceOnGuiThread mode only
+    void recordFrame();
+    // records the current artboard state into m_recordedDisplayList, to be handed over with the next sync
+    void recordDisplayList();
+
     QRectF artboardRect();
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -177,12 +247,19 @@ private:
     QVector<AnimationInfo> m_animationList;
     QVector<StateMachineInfo> m_stateMachineList;
 
-    std::unique_ptr<rive::File> m_riveFile;
+    std::shared_ptr<rive::File> m_riveFile;
 
     mutable QScopedPointer<QSGTextureProvider> m_textureProvider;
 
     QString m_fileSource;
     LoadingStatus m_loadingStatus { Idle };
+    qreal m_loadingProgress { 0.0 };
+    bool m_asynchronous { false };
+
+    // every load gets a new id, results of loads that got superseded in the meantime are dropped
+    quint64 m_loadRequest { 0 };
+    // asynchronous loads still running, the destructor blocks until they are done
+    QFutureSynchronizer<void> m_loadingFutures;
 
     std::shared_ptr<rive::ArtboardInstance> m_currentArtboardInstance { nullptr };
     std::unique_ptr<rive::LinearAnimationInstance> m_animationInstance { nullptr };
@@ -205,6 +282,19 @@ private:
 
     QElapsedTimer m_elapsedTimer;
     qint64 m_lastUpdateTime;
+
+    // the frame recorded on the gui thread, handed over to the render node in the next sync
+    std::unique_ptr<RiveQtDisplayList> m_recordedDisplayList;
+    bool m_hasRecordedFrame { false };
+    // wakes us up once an image decoded that a recorded frame skipped
+    std::shared_ptr<RiveQtDecodeListener> m_decodeListener;
+
+    // neither animation nor state machine play and nothing changed, no further frames get scheduled
+    bool m_isIdle { false };
+
+    int m_maxFrameRate { 0 };
+    bool m_lockToAnimationFps { false };
+    QTimer m_frameTimer; // requests the next frame once it is due, in case the frame rate is limited
     bool m_geometryChanged { true };
 
     bool m_hasValidRenderNode { false };
@@ -212,6 +302,7 @@ private:
     float m_lastMouseY { 0.f };
 
     int m_frameRate { 0 };
+    int m_updatedComponentCount { 0 };
 
     RiveQSGRenderNode *m_renderNode { nullptr };
 };
@@ -99,6 +99,7 @@ void RiveQtStateMachineInputMap::activateTrigger(const QString &trigger)
     if (!targetInput)
         return;
     targetInput->fire();
+    emit inputChanged();
 }
 
 void RiveQtStateMachineInputMap::onInputValueChanged(const QString &key, const QVariant &value)
@@ -123,6 +124,7 @@ void RiveQtStateMachineInputMap::onInputValueChanged(const QString &key, const Q
             targetInput->value(value.toBool());
             stateMachineInstanceShared->needsAdvance();
             insert(key, value);
+            emit inputChanged();
         }
         break;
     }
@@ -141,6 +143,7 @@ void RiveQtStateMachineInputMap::onInputValueChanged(const QString &key, const Q
         if (value.toFloat() != targetInput->value()) {
             targetInput->value(value.toFloat());
             insert(key, value);
+            emit inputChanged();
         }
         break;
     }
@@ -21,6 +21,10 @@ public:
 
     bool hasDirtyStateMachine() const { return m_dirty; }
 
+signals:
+    // an input got set or a trigger fired, the state machine needs to advance again
+    void inputChanged();
+
 public slots:
     void updateValues();
 
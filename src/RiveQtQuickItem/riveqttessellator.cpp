@@ -0,0 +1,289 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtMath>
+
+#include "riveqttessellator.h"
+
+namespace {
+constexpr int maximumCurveSegments = 100;
+
+QVector2D toVector(const QPainterPath::Element &element)
+{
+    return QVector2D(element.x, element.y);
+}
+}
+
+RiveQtTessellator::RiveQtTessellator(float tolerance)
+    : m_tolerance(qMax(tolerance, 0.001f))
+{
+}
+
+int RiveQtTessellator::tessellate(const QPainterPath &path, QVector<QVector2D> &triangles)
+{
+    m_edges.clear();
+    m_scanlines.clear();
+    m_activeEdges.clear();
+
+    flatten(path);
+
+    // fills always close their sub paths
+    for (int contour = 0; contour < m_contours.size(); ++contour) {
+        const int first = m_contours.at(contour);
+        const int end = contour + 1 < m_contours.size() ? m_contours.at(contour + 1) : m_points.size();
+        for (int i = first; i < end; ++i) {
+            addEdge(m_points.at(i), m_points.at(i + 1 < end ? i + 1 : first));
+        }
+    }
+
+    if (m_edges.isEmpty()) {
+        return 0;
+    }
+
+    std::sort(m_edges.begin(), m_edges.end(), [](const Edge &a, const Edge &b) { return a.y0 < b.y0; });
+
+    m_scanlines.reserve(m_edges.size() * 2);
+    for (const Edge &edge : qAsConst(m_edges)) {
+        m_scanlines.append(edge.y0);
+        m_scanlines.append(edge.y1);
+    }
+    std::sort(m_scanlines.begin(), m_scanlines.end());
+    m_scanlines.erase(std::unique(m_scanlines.begin(), m_scanlines.end()), m_scanlines.end());
+
+    const bool windingFill = path.fillRule() == Qt::WindingFill;
+
+    int vertexCount = 0;
+    int nextEdge = 0;
+
+    for (int i = 0; i + 1 < m_scanlines.size(); ++i) {
+        const float top = m_scanlines.at(i);
+        const float bottom = m_scanlines.at(i + 1);
+
+        m_activeEdges.erase(std::remove_if(m_activeEdges.begin(), m_activeEdges.end(), [top](const Edge *edge) { return edge->y1 <= top; }),
+                            m_activeEdges.end());
+
+        // every edge ends on a scanline, so an edge starting above the band spans all of it
+        while (nextEdge < m_edges.size() && m_edges.at(nextEdge).y0 <= top) {
+            m_activeEdges.append(&m_edges.at(nextEdge));
+            ++nextEdge;
+        }
+
+        if (m_activeEdges.size() < 2) {
+            continue;
+        }
+
+        vertexCount += emitBand(top, bottom, windingFill, triangles);
+    }
+
+    return vertexCount;
+}
+
+int RiveQtTessellator::stencilFan(const QPainterPath &path, QVector<QVector2D> &fan, QVector<QVector2D> &cover)
+{
+    flatten(path);
+
+    if (m_points.isEmpty()) {
+        return 0;
+    }
+
+    float left = m_points.first().x();
+    float right = left;
+    float top = m_points.first().y();
+    float bottom = top;
+
+    int vertexCount = 0;
+
+    for (int contour = 0; contour < m_contours.size(); ++contour) {
+        const int first = m_contours.at(contour);
+        const int end = contour + 1 < m_contours.size() ? m_contours.at(contour + 1) : m_points.size();
+
+        for (int i = first; i < end; ++i) {
+            const QVector2D &point = m_points.at(i);
+            left = qMin(left, point.x());
+            right = qMax(right, point.x());
+            top = qMin(top, point.y());
+            bottom = qMax(bottom, point.y());
+        }
+
+        // overlapping triangles are fine, the stencil buffer sums up their windings
+        for (int i = first + 1; i + 1 < end; ++i) {
+            fan.append(m_points.at(first));
+            fan.append(m_points.at(i));
+            fan.append(m_points.at(i + 1));
+            vertexCount += 3;
+        }
+    }
+
+    if (vertexCount == 0) {
+        return 0;
+    }
+
+    cover.append(QVector2D(left, top));
+    cover.append(QVector2D(right, top));
+    cover.append(QVector2D(right, bottom));
+
+    cover.append(QVector2D(left, top));
+    cover.append(QVector2D(right, bottom));
+    cover.append(QVector2D(left, bottom));
+
+    return vertexCount;
+}
+
+void RiveQtTessellator::flatten(const QPainterPath &path)
+{
+    m_points.clear();
+    m_contours.clear();
+
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element &element = path.elementAt(i);
+
+        switch (element.type) {
+        case QPainterPath::MoveToElement:
+            m_contours.append(m_points.size());
+            m_points.append(toVector(element));
+            break;
+        case QPainterPath::LineToElement:
+            if (m_contours.isEmpty()) {
+                m_contours.append(m_points.size());
+            }
+            m_points.append(toVector(element));
+            break;
+        case QPainterPath::CurveToElement: {
+            if (i + 2 >= path.elementCount() || m_points.isEmpty()) {
+                break;
+            }
+            const QVector2D startPoint = m_points.last(); // copy, appending the curve might reallocate
+            addCubic(startPoint, toVector(element), toVector(path.elementAt(i + 1)), toVector(path.elementAt(i + 2)));
+            i += 2; // Skip the next two control points, as we already processed them.
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void RiveQtTessellator::addEdge(const QVector2D &from, const QVector2D &to)
+{
+    // horizontal edges do not change the winding of any band
+    if (from.y() == to.y()) {
+        return;
+    }
+
+    if (!qIsFinite(from.x()) || !qIsFinite(from.y()) || !qIsFinite(to.x()) || !qIsFinite(to.y())) {
+        return;
+    }
+
+    const bool downwards = from.y() < to.y();
+    const QVector2D &top = downwards ? from : to;
+    const QVector2D &bottom = downwards ? to : from;
+
+    Edge edge;
+    edge.x0 = top.x();
+    edge.y0 = top.y();
+    edge.x1 = bottom.x();
+    edge.y1 = bottom.y();
+    edge.dxdy = (edge.x1 - edge.x0) / (edge.y1 - edge.y0);
+    edge.winding = downwards ? 1 : -1;
+
+    m_edges.append(edge);
+}
+
+int RiveQtTessellator::curveSegments(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, float tolerance)
+{
+    // Wang's formula: the number of segments needed to stay within the tolerance, based on the second differences
+    const float dd = qMax((p0 - 2.f * p1 + p2).length(), (p1 - 2.f * p2 + p3).length());
+    const float segments = std::ceil(std::sqrt(0.75f * dd / qMax(tolerance, 0.001f)));
+    if (!qIsFinite(segments)) {
+        return 1;
+    }
+    return int(qBound(1.f, segments, float(maximumCurveSegments)));
+}
+
+void RiveQtTessellator::addCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3)
+{
+    const int segments = curveSegments(p0, p1, p2, p3, m_tolerance);
+
+    // p0 is already part of the contour
+    for (int i = 1; i < segments; ++i) {
+        const float t = float(i) / segments;
+        const float oneMinusT = 1.f - t;
+        m_points.append(oneMinusT * oneMinusT * oneMinusT * p0 + 3.f * oneMinusT * oneMinusT * t * p1 + 3.f * oneMinusT * t * t * p2
+                        + t * t * t * p3);
+    }
+    m_points.append(p3);
+}
+
+int RiveQtTessellator::emitBand(float top, float bottom, bool windingFill, QVector<QVector2D> &triangles)
+{
+    const auto isInside = [windingFill](int winding) { return windingFill ? winding != 0 : (winding & 1) != 0; };
+    // slices never get thinner than this, protects against endless splitting of almost parallel edges
+    const float minimumSliceHeight = m_tolerance * 0.01f;
+
+    int vertexCount = 0;
+
+    while (top < bottom) {
+        std::sort(m_activeEdges.begin(), m_activeEdges.end(), [top, bottom](const Edge *a, const Edge *b) {
+            const float xa = a->x(top);
+            const float xb = b->x(top);
+            return xa != xb ? xa < xb : a->x(bottom) < b->x(bottom);
+        });
+
+        // edges crossing inside the band swap their order, cut the band at the first crossing
+        float sliceBottom = bottom;
+        for (int i = 0; i + 1 < m_activeEdges.size(); ++i) {
+            const Edge *a = m_activeEdges.at(i);
+            const Edge *b = m_activeEdges.at(i + 1);
+            const float slopeDifference = a->dxdy - b->dxdy;
+            if (a->x(bottom) > b->x(bottom) && slopeDifference > 0.f) {
+                sliceBottom = qMin(sliceBottom, top + (b->x(top) - a->x(top)) / slopeDifference);
+            }
+        }
+        sliceBottom = qMin(bottom, qMax(sliceBottom, top + minimumSliceHeight));
+        // far from the origin the minimum height can get lost in the float precision of top, always move on
+        if (!(sliceBottom > top)) {
+            sliceBottom = std::nextafter(top, bottom);
+        }
+
+        int winding = 0;
+        const Edge *left = nullptr;
+
+        for (const Edge *edge : qAsConst(m_activeEdges)) {
+            const bool wasInside = isInside(winding);
+            winding += edge->winding;
+            const bool inside = isInside(winding);
+
+            if (!wasInside && inside) {
+                left = edge;
+            } else if (wasInside && !inside && left) {
+                const QVector2D topLeft(left->x(top), top);
+                const QVector2D topRight(edge->x(top), top);
+                const QVector2D bottomLeft(left->x(sliceBottom), sliceBottom);
+                const QVector2D bottomRight(edge->x(sliceBottom), sliceBottom);
+
+                if (topRight.x() <= topLeft.x() && bottomRight.x() <= bottomLeft.x()) {
+                    continue;
+                }
+
+                triangles.append(topLeft);
+                triangles.append(topRight);
+                triangles.append(bottomRight);
+
+                triangles.append(topLeft);
+                triangles.append(bottomRight);
+                triangles.append(bottomLeft);
+
+                vertexCount += 6;
+            }
+        }
+
+        top = sliceBottom;
+    }
+
+    return vertexCount;
+}
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QtGlobal>
+#include <QPainterPath>
+#include <QVector>
+#include <QVector2D>
+
+// Triangulates the fill of a path.
+//
+// Curves get flattened adaptively, the resulting polygon is cut into horizontal bands at every vertex
+// and every edge intersection. Each band then is a list of trapezoids between neighbouring edges,
+// the ones inside the path according to its fill rule (winding or odd even) are emitted as two triangles.
+// Self intersecting and overlapping sub paths are handled, holes do not need any special treatment.
+//
+// For stencil and cover filling the flattened contours are only turned into triangle fans instead,
+// the fill rule is resolved by the stencil buffer then.
+class RiveQtTessellator
+{
+public:
+    // tolerance is the maximum distance of the flattened curve to the real curve in path coordinates
+    explicit RiveQtTessellator(float tolerance = 0.25f);
+
+    void setTolerance(float tolerance) { m_tolerance = qMax(tolerance, 0.001f); }
+
+    // appends a triangle list to triangles, returns the number of vertices appended
+    int tessellate(const QPainterPath &path, QVector<QVector2D> &triangles);
+
+    // Appends one triangle fan per sub path to fan, as triangle list, and two triangles covering the bounds of the path to cover.
+    // Returns the number of vertices appended to fan.
+    int stencilFan(const QPainterPath &path, QVector<QVector2D> &fan, QVector<QVector2D> &cover);
+
+    // number of line segments a cubic bezier needs to stay within tolerance of the real curve
+    static int curveSegments(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, float tolerance);
+
+private:
+    struct Edge
+    {
+        float x(float y) const { return x0 + (y - y0) * dxdy; }
+
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+        float dxdy;
+        int winding; // +1 for edges pointing downwards, -1 for edges pointing upwards
+    };
+
+    void flatten(const QPainterPath &path);
+    void addCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3);
+    void addEdge(const QVector2D &from, const QVector2D &to);
+
+    int emitBand(float top, float bottom, bool windingFill, QVector<QVector2D> &triangles);
+
+    float m_tolerance;
+
+    QVector<QVector2D> m_points; // flattened sub paths, one after another
+    QVector<int> m_contours; // index of the first point of every sub path in m_points
+    QVector<Edge> m_edges;
+    QVector<float> m_scanlines;
+    QVector<const Edge *> m_activeEdges;
+};
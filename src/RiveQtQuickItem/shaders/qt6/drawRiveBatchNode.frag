@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+layout(location = 0) out vec4 fragColor;
+
+layout(location = 0) in vec4 vertexColor;
+
+void main()
+{
+    fragColor = vertexColor;
+}
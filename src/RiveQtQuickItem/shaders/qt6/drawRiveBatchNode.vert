@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+layout(location = 0) in vec2 vertex; // already transformed into artboard coordinates
+layout(location = 1) in vec4 aColor; // color with opacity applied
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                     //0
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+layout(location = 0) out vec4 vertexColor;
+
+void main()
+{
+    vertexColor = aColor;
+
+    gl_Position = qt_Matrix * vec4(vertex, 0.0, 1.0);
+}
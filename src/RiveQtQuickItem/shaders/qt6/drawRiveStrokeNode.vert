@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+// Expands the centerline of a stroke, every instance is one segment, join or cap.
+// The corners of the drawn triangles come from a template shared by all instances:
+// z is the part, 0 for segments, 1 for joins and 2 for caps.
+// Segments: x is the side of the centerline (-1 or 1), y is 0 at the start and 1 at the end.
+// Joins and caps are fans around their point: y is 0 for the center and 1 on the rim, x the position along the rim (0 to 1).
+layout(location = 0) in vec3 corner;
+layout(location = 1) in vec4 points; // start and end point, joins and caps only use the start
+layout(location = 2) in vec4 normals; // segments and joins: start and end normal, caps: normal and outward direction
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                     //0
+    float qt_Opacity;                   //64
+    float gradientRadius;               //68
+    int useGradient;                    //72
+    int blendMode;                      //76
+    vec2 gradientFocalPoint;            //80
+    vec2 gradientCenter;                //88
+    vec2 startPoint;                    //96
+    vec2 endPoint;                      //104
+    int numberOfStops;                  //112
+    int gradientType;                   //116
+    vec4 color;                         //128
+    vec4 stopColors[20];                //144
+    vec2 gradientPositions[20];         //464
+    mat4 tranformMatrix;                //784
+    float strokeHalfWidth;              //848
+    int strokeJoin;                     //852 0 -> miter, 1 -> bevel, 2 -> round
+    int strokeCap;                      //856 0 -> flat, 1 -> square, 2 -> round
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec2 originalVertex;
+
+const float PI = 3.14159265359;
+const float miterLimit = 4.0; // in half widths, sharper joins fall back to bevel
+
+vec2 rotate(vec2 v, float angle)
+{
+    float c = cos(angle);
+    float s = sin(angle);
+    return vec2(c * v.x - s * v.y, s * v.x + c * v.y);
+}
+
+// offset of a rim corner of a join, in half widths
+vec2 joinOffset(vec2 normalIn, vec2 normalOut, float fraction)
+{
+    float turn = normalIn.x * normalOut.y - normalIn.y * normalOut.x;
+    // the join fills the gap on the outer side of the turn
+    float side = turn > 0.0 ? -1.0 : 1.0;
+
+    if (strokeJoin == 2) {
+        float angle = acos(clamp(dot(normalIn, normalOut), -1.0, 1.0));
+        return side * rotate(normalIn, (turn > 0.0 ? angle : -angle) * fraction);
+    }
+
+    if (strokeJoin == 0 && fraction > 0.0 && fraction < 1.0) {
+        // all inner corners of the fan meet in the miter point, only the first and last triangle have an area
+        vec2 bisector = normalIn + normalOut;
+        vec2 miter = bisector * (2.0 / max(dot(bisector, bisector), 0.0001));
+        if (dot(miter, miter) <= miterLimit * miterLimit) {
+            return side * miter;
+        }
+    }
+
+    // bevel, only the last triangle of the fan has an area
+    return side * (fraction < 1.0 ? normalIn : normalOut);
+}
+
+// offset of a rim corner of a cap, in half widths
+vec2 capOffset(vec2 normal, vec2 outward, float fraction)
+{
+    if (strokeCap == 2) {
+        float angle = fraction * PI;
+        return cos(angle) * normal + sin(angle) * outward;
+    }
+
+    if (strokeCap == 1) {
+        if (fraction <= 0.0) {
+            return normal;
+        }
+        if (fraction >= 1.0) {
+            return -normal;
+        }
+        return (fraction <= 0.5 ? normal : -normal) + outward;
+    }
+
+    return vec2(0.0);
+}
+
+void main()
+{
+    vec2 position;
+
+    if (corner.z < 0.5) {
+        vec2 normal = corner.y < 0.5 ? normals.xy : normals.zw;
+        position = mix(points.xy, points.zw, corner.y) + corner.x * strokeHalfWidth * normal;
+    } else {
+        vec2 offset = vec2(0.0);
+        if (corner.y > 0.5) {
+            offset = corner.z < 1.5 ? joinOffset(normals.xy, normals.zw, corner.x) : capOffset(normals.xy, normals.zw, corner.x);
+        }
+        position = points.xy + offset * strokeHalfWidth;
+    }
+
+    texCoord = vec2(0.0);
+    originalVertex = position;
+
+    gl_Position = qt_Matrix * tranformMatrix * vec4(position, 0.0, 1.0);
+}
@@ -26,6 +26,9 @@ layout(std140, binding = 0) uniform buf {
     vec4 stopColors[20];                //144
     vec2 gradientPositions[20];         //464
     mat4 tranformMatrix;                //784
+    float strokeHalfWidth;              //848
+    int strokeJoin;                     //852
+    int strokeCap;                      //856
 };
 layout(binding = 1) uniform sampler2D image;
 
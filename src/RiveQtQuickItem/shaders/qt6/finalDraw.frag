@@ -17,6 +17,8 @@ layout(std140, binding = 0) uniform buf {
     float right;
     float top;
     float bottom;
+    float contentScaleX; // the item only covers the top left part of the texture
+    float contentScaleY;
 };
 
 layout(binding = 1) uniform sampler2D u_texture;
@@ -24,7 +26,10 @@ layout(binding = 1) uniform sampler2D u_texture;
 vec4 drawTexture(sampler2D s_texture, vec2 texCoord) {
     if (texCoord.x >= left && texCoord.x <= right &&
         texCoord.y >= top && texCoord.y <= bottom) {
-        return texture(s_texture, texCoord);
+        // texCoord is flipped already for y up framebuffers, the item starts at the other end of the texture then
+        vec2 contentCoord = vec2(texCoord.x * contentScaleX,
+                                 flipped == 0 ? texCoord.y * contentScaleY : 1.0 - (1.0 - texCoord.y) * contentScaleY);
+        return texture(s_texture, contentCoord);
     } else {
         return vec4(0.0, 0.0, 0.0, 0.0);  // Return a transparent color for pixels outside the viewport
     }